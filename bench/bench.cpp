@@ -0,0 +1,276 @@
+// Micro-benchmarks for the interpreter's stages, each measured in isolation
+// on generated programs. Reports wall time per operation and heap traffic.
+//
+//   interpreter_bench [--scale=N] [--min-time=MS] [filter]
+//
+// `scale` multiplies every workload's size (default 1); `filter` runs only
+// the benchmarks whose name contains it.
+
+#include "allocation.h"
+#include "environment.h"
+#include "evaluator.h"
+#include "heap.h"
+#include "parser.h"
+#include "resolver.h"
+#include "tokeniser.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Synthetic workloads. Each returns a script that runs silently (no print),
+// so evaluation cost isn't mixed with output.
+struct Workload {
+    const char* name;
+    std::string source;
+};
+
+// 1 + 2 - 3 + 4 ... : one very wide expression
+static std::string longChain(int terms) {
+    std::string source = "var x = 0";
+    for (int i = 1; i <= terms; i++) {
+        source += (i % 2 ? " + " : " - ") + std::to_string(i);
+    }
+    return source + ";\n";
+}
+
+// { { { ... } } } with a declaration and a read at every level
+static std::string deepNesting(int depth) {
+    std::string source;
+    for (int i = 0; i < depth; i++) {
+        source += "{ var d" + std::to_string(i) + " = " + std::to_string(i) + ";\n";
+    }
+    source += "d0 = d0 + 1;\n";
+    source += std::string(depth, '}') + "\n";
+    return source;
+}
+
+// Many globals, each initialised from the previous one
+static std::string manyVariables(int count) {
+    std::string source = "var v0 = 0;\n";
+    for (int i = 1; i < count; i++) {
+        source += "var v" + std::to_string(i) + " = v" + std::to_string(i - 1) + " + 1;\n";
+    }
+    return source;
+}
+
+// One block with many locals and assignments between them
+static std::string wideBlock(int count) {
+    std::string source = "{\n";
+    for (int i = 0; i < count; i++) {
+        source += "  var w" + std::to_string(i) + " = " + std::to_string(i) + ";\n";
+    }
+    for (int i = 1; i < count; i++) {
+        source += "  w" + std::to_string(i) + " = w" + std::to_string(i - 1) + " * 2;\n";
+    }
+    return source + "}\n";
+}
+
+// The same few nested blocks executed over and over: frame setup per block
+static std::string repeatedBlocks(int repeats) {
+    std::string source = "var total = 0;\n";
+    for (int i = 0; i < repeats; i++) {
+        source += "{ var a = 1; { var b = a + 1; { var c = b + 1; { var d = c + 1; total = total + d; } } } }\n";
+    }
+    return source;
+}
+
+// `blocks` as a loop: the same work without unrolling the source
+static std::string loop(int repeats) {
+    return "var total = 0;\n"
+           "for (var i = 0; i < " + std::to_string(repeats) + "; i = i + 1) {\n"
+           "  var a = 1; { var b = a + 1; { var c = b + 1; { var d = c + 1; total = total + d; } } }\n"
+           "}\n";
+}
+
+// Rule-style branching: compound conditions evaluated on every iteration
+static std::string branches(int repeats) {
+    return "var hits = 0;\n"
+           "for (var i = 0; i < " + std::to_string(repeats) + "; i = i + 1) {\n"
+           "  if (i > 10 and i < 900 or i == 950) hits = hits + 1;\n"
+           "  if (!(i >= 500) and i != 7) hits = hits + 2; else hits = hits - 1;\n"
+           "}\n";
+}
+
+// Naive recursive fib: call overhead, argument binding and returns
+static std::string calls(int n) {
+    return "fun fib(n) { if (n < 2) return n; return fib(n - 2) + fib(n - 1); }\n"
+           "var result = fib(" + std::to_string(n) + ");\n";
+}
+
+// Accumulator recursion: every call is a tail call
+static std::string tailCalls(int n) {
+    return "fun count(n, acc) { if (n == 0) return acc; return count(n - 1, acc + 1); }\n"
+           "var result = count(" + std::to_string(n) + ", 0);\n";
+}
+
+// Closures that refer to themselves: cycles only the collector reclaims
+static std::string closures(int count) {
+    return "fun make() { var self = nil; fun f() { return self; } self = f; return f; }\n"
+           "for (var i = 0; i < " + std::to_string(count) + "; i = i + 1) { var f = make(); }\n";
+}
+
+// A string grown one piece at a time, as report-building scripts do
+static std::string appends(int count) {
+    std::string source = "var s = \"\";\n";
+    for (int i = 0; i < count; i++) {
+        source += "s = s + \"item " + std::to_string(i) + ", \";\n";
+    }
+    return source;
+}
+
+struct Result {
+    double nsPerOp;
+    double bytesPerOp;
+    double allocsPerOp;
+};
+
+// Repeats `op` until `minTime` has elapsed; one untimed warm-up run first
+static Result measure(const std::function<void()>& op, std::chrono::milliseconds minTime) {
+    op();
+
+    AllocationStats before = allocationStats();  // Counted by the core's operator new
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::steady_clock::duration::zero();
+    long iterations = 0;
+    while (elapsed < minTime) {
+        op();
+        iterations++;
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+
+    AllocationStats after = allocationStats();
+    double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    return {ns / iterations,
+            static_cast<double>(after.bytes - before.bytes) / iterations,
+            static_cast<double>(after.allocations - before.allocations) / iterations};
+}
+
+static void report(const std::string& name, const Result& result) {
+    std::printf("%-32s %14.0f ns/op %14.0f B/op %10.1f allocs/op\n",
+                name.c_str(), result.nsPerOp, result.bytesPerOp, result.allocsPerOp);
+}
+
+static std::unique_ptr<Program> parse(const std::string& source) {
+    Lexer lexer(source);
+    Parser parser(lexer);
+    auto program = parser.parseProgram();
+    Resolver resolver;
+    resolver.resolve(program);
+    return program;
+}
+
+int main(int argc, char* argv[]) {
+    int scale = 1;
+    std::chrono::milliseconds minTime(200);
+    std::string filter;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 8, "--scale=") == 0) {
+            scale = std::max(1, std::atoi(arg.c_str() + 8));
+        } else if (arg.compare(0, 11, "--min-time=") == 0) {
+            minTime = std::chrono::milliseconds(std::atoi(arg.c_str() + 11));
+        } else if (arg == "--help") {
+            std::printf("Usage: %s [--scale=N] [--min-time=MS] [filter]\n", argv[0]);
+            return 0;
+        } else {
+            filter = arg;
+        }
+    }
+
+    std::vector<Workload> workloads = {
+        {"chain", longChain(2000 * scale)},
+        {"nesting", deepNesting(200 * scale)},
+        {"variables", manyVariables(2000 * scale)},
+        {"wide_block", wideBlock(2000 * scale)},
+        {"blocks", repeatedBlocks(1000 * scale)},
+        {"concat", appends(5000 * scale)},
+        {"loop", loop(1000 * scale)},
+        {"branches", branches(1000 * scale)},
+        {"calls", calls(14 + scale)},
+        {"tail_calls", tailCalls(1000 * scale)},
+        {"closures", closures(1000 * scale)},
+    };
+
+    auto selected = [&](const std::string& name) {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    };
+
+    for (const Workload& workload : workloads) {
+        std::string prefix = std::string(workload.name) + "/";
+        const std::string& source = workload.source;
+
+        if (selected(prefix + "tokenize")) {
+            report(prefix + "tokenize", measure([&] {
+                Lexer lexer(source);
+                while (lexer.next().type != TokenType::EOF_TOKEN) {}
+            }, minTime));
+        }
+
+        if (selected(prefix + "parse")) {
+            report(prefix + "parse", measure([&] {
+                Lexer lexer(source);
+                Parser parser(lexer);
+                auto program = parser.parseProgram();
+            }, minTime));
+        }
+
+        if (selected(prefix + "evaluate")) {
+            auto program = parse(source);  // Parsed and resolved once, run many times
+            report(prefix + "evaluate", measure([&] {
+                Evaluator evaluator;
+                evaluator.evaluateProgram(program);
+            }, minTime));
+        }
+    }
+
+    // Environment access on its own: name lookups (globals) and slot lookups (locals)
+    const int names = 1000 * scale;
+    std::vector<Symbol> keys;
+    for (int i = 0; i < names; i++) {
+        keys.push_back(intern("name" + std::to_string(i)));
+    }
+
+    if (selected("environment/get")) {
+        Environment globals;
+        for (Symbol key : keys) {
+            globals.define(key, Value(1.0));
+        }
+        double sum = 0;
+        Result result = measure([&] {
+            for (Symbol key : keys) {
+                sum += globals.get(key).number;
+            }
+        }, minTime);
+        result.nsPerOp /= names;
+        result.bytesPerOp /= names;
+        result.allocsPerOp /= names;
+        report("environment/get", result);
+        if (sum < 0) std::printf("%f\n", sum);  // Keeps the loop from being optimised out
+    }
+
+    if (selected("environment/slot")) {
+        const int depth = 8;
+        Heap heap;
+        Environment* environment = heap.make<Environment>(nullptr, 16);
+        for (int i = 0; i < depth; i++) {
+            environment = heap.make<Environment>(environment, 16);
+        }
+        double sum = 0;
+        Result result = measure([&] {
+            for (int i = 0; i < names; i++) {
+                sum += environment->slotAt(i % (depth + 1), i % 16).number;
+            }
+        }, minTime);
+        result.nsPerOp /= names;
+        result.bytesPerOp /= names;
+        result.allocsPerOp /= names;
+        report("environment/slot", result);
+        if (sum < 0) std::printf("%f\n", sum);
+    }
+
+    return 0;
+}
@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+"""Regenerates the end-to-end benchmark corpus in this directory.
+
+The first workloads are long straight-line code, which stresses the
+lexer, parser and resolver as much as the evaluator. `loops`, `calls` and
+`garbage` are short programs that run for a while: loop frames, calls and
+returns, closures, and enough short-lived strings and closure cycles to
+keep the collector busy. Output is deterministic (fixed seed); rerun this
+only when a workload changes, then refresh the baseline with
+`run_corpus.py --update-baseline`.
+"""
+
+import os
+import random
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def arithmetic(rng):
+    # Running accumulators updated with mixed arithmetic; printed now and then
+    lines = ["var a = 1;", "var b = 2;", "var c = 3;", "var total = 0;"]
+    names = ["a", "b", "c"]
+    for i in range(6000):
+        target = rng.choice(names)
+        x, y = rng.sample(names, 2)
+        op = rng.choice(["+", "-", "*"])
+        k = rng.randint(1, 9)
+        lines.append(f"{target} = ({x} {op} {y} + {k}) / {k + 1};")
+        if i % 7 == 0:
+            lines.append(f"total = total + {target} * {k} - (a - b);")
+        if i % 500 == 0:
+            lines.append("print total;")
+    lines.append("print total;")
+    return lines
+
+
+def strings(rng):
+    # Concatenation in short-lived blocks so strings stay bounded in size
+    words = ["lox", "tree", "walk", "scope", "token", "arena", "value", "print"]
+    lines = ['var log = "";']
+    for i in range(1500):
+        a, b, c = (rng.choice(words) for _ in range(3))
+        lines.append("{")
+        lines.append(f'  var s = "{a}" + "-";')
+        lines.append(f'  s = s + "{b}" + "-" + "{c}";')
+        lines.append('  var t = s + s;')
+        lines.append(f'  if (t == s + s) log = s; else log = "{a}";')
+        lines.append("}")
+        if i % 100 == 0:
+            lines.append("print log;")
+    lines.append("print log;")
+    return lines
+
+
+def scopes(rng):
+    # Nested blocks with shadowing; reads reach several scopes out
+    lines = ["var depth = 0;", "var seen = 0;"]
+    for i in range(800):
+        levels = rng.randint(2, 6)
+        for level in range(levels):
+            lines.append("  " * level + "{")
+            lines.append("  " * level + f"  var v{level} = {level};")
+            lines.append("  " * level + f"  var seen = seen + v{level};")
+        inner = "  " * levels
+        reads = " + ".join(f"v{level}" for level in range(levels))
+        lines.append(f"{inner}depth = depth + {reads};")
+        for level in reversed(range(levels)):
+            lines.append("  " * level + "}")
+        if i % 100 == 0:
+            lines.append("print depth;")
+    lines.append("print depth;")
+    return lines
+
+
+def prints(rng):
+    # Output-bound: numbers, strings and booleans straight to stdout
+    lines = ["var n = 0;"]
+    for i in range(10000):
+        kind = i % 4
+        if kind == 0:
+            lines.append(f"n = n + {rng.randint(1, 100)} / 8;")
+            lines.append("print n;")
+        elif kind == 1:
+            lines.append(f'print "line " + "{i}";')
+        elif kind == 2:
+            lines.append(f"print n > {rng.randint(1, 5000)};")
+        else:
+            lines.append(f"print {rng.random() * 1000:.5f};")
+    return lines
+
+
+def loops(rng):
+    # Nested for/while loops with branches on the loop variables
+    lines = ["var total = 0;"]
+    for i in range(20):
+        outer, inner, k = rng.randint(150, 250), rng.randint(10, 30), rng.randint(2, 9)
+        lines.append(f"for (var i = 0; i < {outer}; i = i + 1) {{")
+        lines.append("  var j = 0;")
+        lines.append(f"  while (j < {inner}) {{")
+        lines.append(f"    if (j > {k} and i != j or j == 0) total = total + i * {k} - j;")
+        lines.append(f"    else total = total - {k};")
+        lines.append("    j = j + 1;")
+        lines.append("  }")
+        lines.append("}")
+        lines.append("print total;")
+    return lines
+
+
+def calls(rng):
+    # Recursion, tail calls, closures over loop state and higher-order calls
+    lines = [
+        "fun fib(n) { if (n < 2) return n; return fib(n - 2) + fib(n - 1); }",
+        "fun count(n, acc) { if (n == 0) return acc; return count(n - 1, acc + 1); }",
+        "fun makeAdder(k) { fun add(x) { return x + k; } return add; }",
+        "fun apply(f, n, x) { for (var i = 0; i < n; i = i + 1) x = f(x); return x; }",
+        "var total = 0;",
+    ]
+    for i in range(12):
+        n, depth, k, times = rng.randint(16, 19), rng.randint(2000, 6000), rng.randint(1, 9), rng.randint(500, 1500)
+        lines.append(f"total = total + fib({n});")
+        lines.append(f"total = total + count({depth}, 0);")
+        lines.append(f"total = apply(makeAdder({k}), {times}, total);")
+        lines.append("print total;")
+    return lines
+
+
+def garbage(rng):
+    # Short-lived strings and self-referencing closures, all unreachable by
+    # the next iteration, so memory stays flat only if they are collected
+    words = ["lox", "heap", "mark", "sweep", "frame", "scope"]
+    lines = [
+        "fun cycle(tag) { var self = nil; fun get() { self = get; return tag; } get(); return get; }",
+        'var last = "";',
+    ]
+    for i in range(10):
+        a, b = rng.sample(words, 2)
+        lines.append(f"for (var i = 0; i < {rng.randint(3000, 5000)}; i = i + 1) {{")
+        lines.append(f'  var s = "{a}" + "-" + "{b}";')
+        lines.append('  s = s + s + "!";')
+        lines.append("  last = cycle(s)();")
+        lines.append("}")
+        lines.append("print last;")
+    return lines
+
+
+WORKLOADS = {
+    "arithmetic": arithmetic,
+    "strings": strings,
+    "scopes": scopes,
+    "prints": prints,
+    "loops": loops,
+    "calls": calls,
+    "garbage": garbage,
+}
+
+
+def main():
+    for name, generate in WORKLOADS.items():
+        lines = generate(random.Random(name))
+        with open(os.path.join(HERE, name + ".lox"), "w") as out:
+            out.write(f"// Generated by generate.py ({name} workload); do not edit\n")
+            out.write("\n".join(lines) + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,41 @@
+// Runs a command and reports its peak resident set size on stderr as
+// `peak_rss_kb=N`, exiting with the command's status.
+//
+// Linux folds a parent's RSS high-water mark into a forked child's
+// ru_maxrss, so measuring straight from Python would report Python's own
+// footprint for any small program. Forking from this small process keeps
+// that floor at a few hundred KiB.
+
+#include <cstdio>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <command> [args...]\n", argv[0]);
+        return 2;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::perror("fork");
+        return 2;
+    }
+    if (pid == 0) {
+        execvp(argv[1], argv + 1);
+        std::perror("execvp");
+        _exit(127);
+    }
+
+    int status = 0;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0) {
+        std::perror("wait4");
+        return 2;
+    }
+
+    std::fprintf(stderr, "peak_rss_kb=%ld\n", usage.ru_maxrss);
+    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    return WEXITSTATUS(status);
+}
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""End-to-end benchmark gate for the interpreter.
+
+Runs every bench/corpus/*.lox through `interpreter run` several times and
+records, per workload, the median and minimum wall time, the peak RSS and
+a SHA-256 of stdout. Results are written as JSON and compared against a
+stored baseline: a different checksum or exit code always fails, and time
+or memory above baseline * (1 + tolerance) fails as a regression.
+
+    run_corpus.py --interpreter build/interpreter
+    run_corpus.py --interpreter build/interpreter --update-baseline
+    run_corpus.py --interpreter build/interpreter -- --opt-level=0
+
+The stored baseline is only meaningful on the machine that recorded it;
+refresh it before comparing on different hardware.
+
+Peak RSS needs the `peak_rss` helper built next to the interpreter (pass
+--peak-rss otherwise); without it memory is not recorded or compared.
+"""
+
+import argparse
+import glob
+import hashlib
+import json
+import os
+import re
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def run_once(command):
+    with tempfile.TemporaryFile() as out:
+        start = time.perf_counter()
+        proc = subprocess.run(command, stdout=out, stderr=subprocess.PIPE)
+        elapsed = time.perf_counter() - start
+        out.seek(0)
+        checksum = hashlib.sha256(out.read()).hexdigest()
+    match = re.search(rb"peak_rss_kb=(\d+)\s*$", proc.stderr)
+    return elapsed, int(match.group(1)) if match else 0, checksum, proc.returncode
+
+
+def measure(command, runs):
+    times, rss, checksums, codes = [], [], set(), set()
+    for _ in range(runs):
+        elapsed, maxrss, checksum, code = run_once(command)
+        times.append(elapsed)
+        rss.append(maxrss)
+        checksums.add(checksum)
+        codes.add(code)
+    if len(checksums) != 1 or len(codes) != 1:
+        raise SystemExit(f"{command[-1]}: output differs between runs")
+    return {
+        "median_ms": round(statistics.median(times) * 1000, 3),
+        "min_ms": round(min(times) * 1000, 3),
+        "peak_rss_kb": max(rss),
+        "checksum": checksums.pop(),
+        "exit_code": codes.pop(),
+    }
+
+
+def compare(results, baseline, tolerance, rss_tolerance):
+    failures = []
+    for name, result in results.items():
+        base = baseline.get(name)
+        if base is None:
+            print(f"  {name}: no baseline entry, skipped")
+            continue
+        if result["checksum"] != base["checksum"] or result["exit_code"] != base["exit_code"]:
+            failures.append(f"{name}: output changed (checksum or exit code)")
+        if result["median_ms"] > base["median_ms"] * (1 + tolerance):
+            failures.append(f"{name}: {result['median_ms']:.1f} ms vs baseline "
+                            f"{base['median_ms']:.1f} ms (+{tolerance:.0%} allowed)")
+        measured = result["peak_rss_kb"] and base["peak_rss_kb"]
+        if measured and result["peak_rss_kb"] > base["peak_rss_kb"] * (1 + rss_tolerance):
+            failures.append(f"{name}: {result['peak_rss_kb']} KiB peak RSS vs baseline "
+                            f"{base['peak_rss_kb']} KiB (+{rss_tolerance:.0%} allowed)")
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--interpreter", required=True, help="path to the interpreter binary")
+    parser.add_argument("--peak-rss", help="path to the peak_rss helper (default: next to the interpreter)")
+    parser.add_argument("--corpus", default=os.path.join(HERE, "corpus"))
+    parser.add_argument("--baseline", default=os.path.join(HERE, "baseline.json"))
+    parser.add_argument("--output", default="corpus_results.json", help="where to write this run's results")
+    parser.add_argument("--runs", type=int, default=5)
+    parser.add_argument("--tolerance", type=float, default=0.15, help="allowed slowdown, 0.15 = 15%%")
+    parser.add_argument("--rss-tolerance", type=float, default=0.10, help="allowed peak RSS growth")
+    parser.add_argument("--update-baseline", action="store_true", help="store this run as the new baseline")
+    parser.add_argument("--filter", default="", help="only run workloads whose name contains this")
+    parser.add_argument("extra", nargs="*", help="extra flags passed to `interpreter run`")
+    args = parser.parse_args()
+
+    peak_rss = args.peak_rss or os.path.join(os.path.dirname(os.path.abspath(args.interpreter)), "peak_rss")
+    launcher = [peak_rss] if os.access(peak_rss, os.X_OK) else []
+    if not launcher:
+        print(f"note: {peak_rss} not found, peak RSS is not measured")
+
+    results = {}
+    for script in sorted(glob.glob(os.path.join(args.corpus, "*.lox"))):
+        name = os.path.splitext(os.path.basename(script))[0]
+        if args.filter not in name:
+            continue
+        command = [*launcher, args.interpreter, "run", *args.extra, script]
+        results[name] = measure(command, args.runs)
+        r = results[name]
+        print(f"{name:<12} {r['median_ms']:9.1f} ms (min {r['min_ms']:.1f})  "
+              f"{r['peak_rss_kb']:8} KiB  {r['checksum'][:12]}")
+
+    with open(args.output, "w") as out:
+        json.dump(results, out, indent=2, sort_keys=True)
+        out.write("\n")
+
+    if args.update_baseline:
+        with open(args.baseline, "w") as out:
+            json.dump(results, out, indent=2, sort_keys=True)
+            out.write("\n")
+        print(f"baseline updated: {args.baseline}")
+        return 0
+
+    if not os.path.exists(args.baseline):
+        print(f"no baseline at {args.baseline}; rerun with --update-baseline")
+        return 1
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    failures = compare(results, baseline, args.tolerance, args.rss_tolerance)
+    for failure in failures:
+        print("REGRESSION " + failure)
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,164 @@
+#include "allocation.h"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <sys/resource.h>
+
+namespace {
+
+// The interpreter is single-threaded, so plain counters are enough
+AllocationStats totals;
+AllocationStats tracked;  // All tags together, since tracking started
+AllocationStats byTag[static_cast<size_t>(MemoryTag::COUNT)];
+bool tracking = false;
+
+// Live allocations while tracking: open addressing over malloc'd memory so
+// the table itself never goes through operator new
+class LiveTable {
+public:
+    struct Record {
+        void* ptr;
+        size_t size;
+        MemoryTag tag;
+    };
+
+    void insert(void* ptr, size_t size, MemoryTag tag) {
+        if ((used + 1) * 2 > capacity) grow();
+        size_t i = slotFor(ptr);
+        while (slots[i].ptr != nullptr && slots[i].ptr != TOMBSTONE) {
+            i = (i + 1) & (capacity - 1);
+        }
+        if (slots[i].ptr == nullptr) used++;
+        slots[i] = {ptr, size, tag};
+        live++;
+    }
+
+    bool erase(void* ptr, Record& record) {
+        if (capacity == 0) return false;
+        for (size_t i = slotFor(ptr); slots[i].ptr != nullptr; i = (i + 1) & (capacity - 1)) {
+            if (slots[i].ptr == ptr) {
+                record = slots[i];
+                slots[i].ptr = TOMBSTONE;
+                live--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    static inline void* const TOMBSTONE = reinterpret_cast<void*>(1);
+
+    Record* slots = nullptr;
+    size_t capacity = 0;  // Power of two
+    size_t used = 0;      // Live records plus tombstones
+    size_t live = 0;
+
+    size_t slotFor(void* ptr) const {
+        uint64_t hash = (reinterpret_cast<uintptr_t>(ptr) >> 4) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(hash >> 20) & (capacity - 1);
+    }
+
+    void grow() {
+        Record* old = slots;
+        size_t oldCapacity = capacity;
+        capacity = 1024;
+        while (capacity < live * 4) capacity *= 2;
+        slots = static_cast<Record*>(std::calloc(capacity, sizeof(Record)));
+        if (slots == nullptr) std::abort();
+        used = live = 0;
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (old[i].ptr != nullptr && old[i].ptr != TOMBSTONE) {
+                insert(old[i].ptr, old[i].size, old[i].tag);
+            }
+        }
+        std::free(old);
+    }
+};
+
+LiveTable liveTable;
+
+void recordAllocation(AllocationStats& stats, size_t size) {
+    stats.allocations++;
+    stats.bytes += size;
+    stats.liveBytes += size;
+    if (stats.liveBytes > stats.peakLiveBytes) stats.peakLiveBytes = stats.liveBytes;
+}
+
+void recordFree(AllocationStats& stats, size_t size) {
+    stats.frees++;
+    stats.liveBytes -= size;
+}
+
+}  // namespace
+
+AllocationStats allocationStats() {
+    return totals;
+}
+
+void startMemoryTracking() {
+    tracking = true;
+}
+
+bool memoryTrackingEnabled() {
+    return tracking;
+}
+
+void reportMemoryStats(std::ostream& out) {
+    static const char* const names[] = {"other", "symbols", "ast", "environments", "functions", "strings"};
+    char buffer[160];
+    std::snprintf(buffer, sizeof buffer, "%-14s %12s %14s %12s %14s %14s\n",
+                  "subsystem", "allocs", "bytes", "frees", "live bytes", "peak live");
+    out << buffer;
+
+    auto row = [&](const char* name, const AllocationStats& stats) {
+        std::snprintf(buffer, sizeof buffer, "%-14s %12llu %14llu %12llu %14llu %14llu\n", name,
+                      static_cast<unsigned long long>(stats.allocations),
+                      static_cast<unsigned long long>(stats.bytes),
+                      static_cast<unsigned long long>(stats.frees),
+                      static_cast<unsigned long long>(stats.liveBytes),
+                      static_cast<unsigned long long>(stats.peakLiveBytes));
+        out << buffer;
+    };
+    for (size_t i = 1; i <= static_cast<size_t>(MemoryTag::COUNT); i++) {
+        size_t tag = i % static_cast<size_t>(MemoryTag::COUNT);  // "other" last
+        row(names[tag], byTag[tag]);
+    }
+    row("total", tracked);
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        out << "peak RSS: " << usage.ru_maxrss << " KiB\n";
+    }
+}
+
+void* operator new(size_t size) {
+    totals.allocations++;
+    totals.bytes += size;
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) throw std::bad_alloc();
+
+    if (tracking) [[unlikely]] {
+        tracking = false;  // The table never allocates, but stay safe against re-entry
+        liveTable.insert(p, size, currentMemoryTag);
+        recordAllocation(byTag[static_cast<size_t>(currentMemoryTag)], size);
+        recordAllocation(tracked, size);
+        tracking = true;
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    if (tracking && p != nullptr) [[unlikely]] {
+        LiveTable::Record record;
+        if (liveTable.erase(p, record)) {  // Blocks from before tracking started aren't listed
+            recordFree(byTag[static_cast<size_t>(record.tag)], record.size);
+            recordFree(tracked, record.size);
+        }
+    }
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
@@ -0,0 +1,45 @@
+#ifndef ALLOCATION_H
+#define ALLOCATION_H
+
+#include <cstdint>
+#include <ostream>
+
+// Running totals kept by the replacement operator new in allocation.cpp.
+// Any binary that calls into this header links that file in, and with it
+// the counting allocator.
+struct AllocationStats {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    uint64_t frees = 0;          // The rest are only kept while tracking
+    uint64_t liveBytes = 0;
+    uint64_t peakLiveBytes = 0;
+};
+
+// Subsystem charged for an allocation, chosen by the innermost MemoryScope
+enum class MemoryTag : uint8_t { OTHER, SYMBOLS, AST, ENVIRONMENTS, FUNCTIONS, STRINGS, COUNT };
+
+inline MemoryTag currentMemoryTag = MemoryTag::OTHER;
+
+class MemoryScope {
+public:
+    explicit MemoryScope(MemoryTag tag) : previous(currentMemoryTag) { currentMemoryTag = tag; }
+    ~MemoryScope() { currentMemoryTag = previous; }
+
+    MemoryScope(const MemoryScope&) = delete;
+    MemoryScope& operator=(const MemoryScope&) = delete;
+
+private:
+    MemoryTag previous;
+};
+
+// Allocation count and bytes over the whole process, always available
+AllocationStats allocationStats();
+
+// `--mem-stats`: from this call on, every allocation is recorded until it
+// is freed, so live and peak bytes can be kept per subsystem. Costs a hash
+// table insert per allocation, so it stays off unless asked for.
+void startMemoryTracking();
+bool memoryTrackingEnabled();
+void reportMemoryStats(std::ostream& out);
+
+#endif // ALLOCATION_H
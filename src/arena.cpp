@@ -0,0 +1,59 @@
+#include "arena.h"
+#include <algorithm>
+#include <cstdint>
+
+Arena::Arena(size_t blockSize) : blockSize(blockSize) {}
+
+Arena::~Arena() {
+    for (auto it = finalizers.rbegin(); it != finalizers.rend(); ++it) {
+        it->destroy(it->object);
+    }
+}
+
+void Arena::reset() {
+    for (auto it = finalizers.rbegin(); it != finalizers.rend(); ++it) {
+        it->destroy(it->object);
+    }
+    finalizers.clear();
+
+    // Keep the block being filled (always a regular one) so a streamed run
+    // doesn't allocate a fresh block for every statement
+    std::unique_ptr<char[]> keep;
+    for (auto& block : blocks) {
+        if (limit != nullptr && block.get() + blockSize == limit) {
+            keep = std::move(block);
+            break;
+        }
+    }
+    blocks.clear();
+    if (keep) {
+        cursor = keep.get();
+        blocks.push_back(std::move(keep));
+    } else {
+        cursor = nullptr;
+        limit = nullptr;
+    }
+}
+
+void* Arena::allocate(size_t size, size_t align) {
+    uintptr_t address = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(uintptr_t(align) - 1);
+    char* start = reinterpret_cast<char*>(address);
+
+    if (cursor == nullptr || start + size > limit) {
+        // Oversized requests get a dedicated block so the current one keeps filling
+        size_t capacity = std::max(blockSize, size + align);
+        blocks.push_back(std::unique_ptr<char[]>(new char[capacity]));  // Left uninitialised on purpose
+        char* block = blocks.back().get();
+
+        address = (reinterpret_cast<uintptr_t>(block) + align - 1) & ~(uintptr_t(align) - 1);
+        start = reinterpret_cast<char*>(address);
+        if (capacity == blockSize) {
+            cursor = start + size;
+            limit = block + capacity;
+        }
+        return start;
+    }
+
+    cursor = start + size;
+    return start;
+}
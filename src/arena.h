@@ -0,0 +1,61 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump-pointer allocator owning every AST node of a Program. Nodes are
+// carved out of large blocks and released together when the arena dies;
+// only the few node types that own heap memory register a destructor.
+class Arena {
+public:
+    explicit Arena(size_t blockSize = 64 * 1024);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t align);
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            finalizers.push_back({[](void* p) { static_cast<T*>(p)->~T(); }, object});
+        }
+        return object;
+    }
+
+    // Copies a run of trivially copyable items (e.g. child pointers) into the arena
+    template <typename T>
+    std::span<T> copyArray(const T* items, size_t count) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (count == 0) return {};
+        T* data = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        std::memcpy(data, items, sizeof(T) * count);
+        return {data, count};
+    }
+
+    // Destroys everything allocated so far; keeps one block for reuse
+    void reset();
+
+private:
+    struct Finalizer {
+        void (*destroy)(void*);
+        void* object;
+    };
+
+    size_t blockSize;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    std::vector<Finalizer> finalizers;
+};
+
+#endif // ARENA_H
@@ -1,60 +1,79 @@
 #ifndef AST_H
 #define AST_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <memory>
-#include <iomanip>
+#include <span>
+#include <sstream>
+#include <vector>
+#include "arena.h"
+#include "symbol.h"
 #include "tokeniser.h"
-#include <fstream>
+#include "value.h"
 
 
 
-class NilValue {
-    public:
-        bool operator==(const NilValue&) const { return true; }  // All NilValues are equal
-        bool operator!=(const NilValue&) const { return false; } // Nil is never different from another Nil
-    
-        friend std::ostream& operator<<(std::ostream& os, const NilValue&) {
-            return os << "nil";
-        }
-    };
+// Node kinds let passes dispatch with a single switch instead of RTTI
+enum class ExprKind : uint8_t { LITERAL, BINARY, GROUPING, UNARY, VARIABLE, ASSIGN, LOGICAL, CALL };
+enum class StmtKind : uint8_t { PRINT, EXPRESSION, VAR_DECL, ASSIGN, BLOCK, IF, WHILE, FUNCTION, RETURN };
+
+enum class BinaryOp : uint8_t {
+    ADD, SUBTRACT, MULTIPLY, DIVIDE,
+    EQUAL, NOT_EQUAL, GREATER, GREATER_EQUAL, LESS, LESS_EQUAL
+};
+
+inline const char* binaryOpText(BinaryOp op) {
+    switch (op) {
+        case BinaryOp::ADD: return "+";
+        case BinaryOp::SUBTRACT: return "-";
+        case BinaryOp::MULTIPLY: return "*";
+        case BinaryOp::DIVIDE: return "/";
+        case BinaryOp::EQUAL: return "==";
+        case BinaryOp::NOT_EQUAL: return "!=";
+        case BinaryOp::GREATER: return ">";
+        case BinaryOp::GREATER_EQUAL: return ">=";
+        case BinaryOp::LESS: return "<";
+        case BinaryOp::LESS_EQUAL: return "<=";
+    }
+    return "?";
+}
+
+// All nodes live in the owning Program's Arena and are linked by raw
+// pointers; names are interned symbols. Nodes have no
+// vtable: toString() dispatches on `kind` like every other pass.
+
 // Base class for all AST nodes
 class Expr {
 public:
-    virtual ~Expr() = default;
-    virtual std::string toString() const = 0;
+    const ExprKind kind;
+    int line = 0;  // Source line; fits in the padding after `kind`
+
+    explicit Expr(ExprKind kind, int line = 0) : kind(kind), line(line) {}
+    std::string toString() const;
 };
 
 // Literal expressions (e.g., numbers, strings, booleans, nil)
 class LiteralExpr : public Expr {
     public:
-        std::variant<std::string,bool,double,NilValue > value;  // Store strings and numbers correctly
+        Value value;  // Literals are stored as ready-made runtime values
     
-        explicit LiteralExpr(const std::string& value) : value(value) {
+        explicit LiteralExpr(bool value) : Expr(ExprKind::LITERAL), value(value){}
+        explicit LiteralExpr(double value) : Expr(ExprKind::LITERAL), value(value) {
         }
-        explicit LiteralExpr(bool value) : value(value){}
-        explicit LiteralExpr(double value) : value(value) {
-        }
-        explicit LiteralExpr(NilValue value):value(value) {}
-        std::string toString() const override {
-            if (std::holds_alternative<double>(value)) {
-                double num = std::get<double>(value);
-                if (num == static_cast<int>(num)) {
-                    return std::to_string(static_cast<int>(num))+".0"; // Return as integer string
-                }
-                std::ostringstream out;
-                out << std::fixed << std::setprecision(3) << num; // Format with 3 decimal places
-                std::string str = out.str();
-                str.erase(str.find_last_not_of('0') + 1, std::string::npos); // Remove trailing zeros
-                if (!str.empty() && str.back() == '.') str.pop_back(); // Remove trailing decimal
-                return str;
-            } else if (std::holds_alternative<std::string>(value)) {
-                return std::get<std::string>(value); // Return string as-is
+        explicit LiteralExpr(NilValue value) : Expr(ExprKind::LITERAL), value(value) {}
+        explicit LiteralExpr(Value value) : Expr(ExprKind::LITERAL), value(std::move(value)) {}  // Folded constants
+        std::string toString() const {
+            if (value.isNumber()) {
+                return formatNumber(value.number, NumberFormat::LITERAL);
+            } else if (value.isString()) {
+                return std::string(value.asString()); // Return string as-is
             }
-            else if(std::holds_alternative<bool>(value)){
-                return std::get<bool>(value)==true ?"true":"false";
+            else if(value.isBool()){
+                return value.boolean ?"true":"false";
             }
-            else if (std::holds_alternative<NilValue>(value)){
+            else if (value.isNil()){
                 return "nil";
             }
             return "Unknown";
@@ -64,27 +83,60 @@ class LiteralExpr : public Expr {
 // Binary expressions (e.g., 2 + 3)
 class BinaryExpr : public Expr {
 public:
-    std::unique_ptr<Expr> left;
-    std::unique_ptr<Expr> right;
-    std::string op;
+    Expr* left;
+    Expr* right;
+    BinaryOp op;  // `line` is the operator's, used for runtime errors
+
+    BinaryExpr(Expr* left, BinaryOp op, Expr* right, int line = 1)
+        : Expr(ExprKind::BINARY, line), left(left), right(right), op(op) {}
+
+    std::string toString() const {
+        return std::string("(") + binaryOpText(op) + " " + left->toString() + " " + right->toString() + ")";
+    }
+};
+
+// `and` / `or`: the right operand is only evaluated when the left one
+// doesn't decide the result, and the result is whichever operand decided it
+class LogicalExpr : public Expr {
+public:
+    Expr* left;
+    Expr* right;
+    bool isAnd;  // Otherwise `or`
+
+    LogicalExpr(Expr* left, bool isAnd, Expr* right, int line)
+        : Expr(ExprKind::LOGICAL, line), left(left), right(right), isAnd(isAnd) {}
+
+    std::string toString() const {
+        return std::string(isAnd ? "(and " : "(or ") + left->toString() + " " + right->toString() + ")";
+    }
+};
+
+class CallExpr : public Expr {
+public:
+    Expr* callee;
+    std::span<Expr*> arguments;  // Array stored in the arena; `line` is the closing paren's
 
-    BinaryExpr(std::unique_ptr<Expr> left, std::string op, std::unique_ptr<Expr> right)
-        : left(std::move(left)), op(std::move(op)), right(std::move(right)) {}
+    CallExpr(Expr* callee, std::span<Expr*> arguments, int line)
+        : Expr(ExprKind::CALL, line), callee(callee), arguments(arguments) {}
 
-    std::string toString() const override {
-        return "(" + op + " " + left->toString() + " " + right->toString() + ")";
+    std::string toString() const {
+        std::string result = callee->toString() + "(";
+        for (size_t i = 0; i < arguments.size(); i++) {
+            result += (i ? ", " : "") + arguments[i]->toString();
+        }
+        return result + ")";
     }
 };
 
 // Grouping expression 
 class GroupingExpr : public Expr {
     public:
-        std::unique_ptr<Expr> expression;
+        Expr* expression;
     
-        explicit GroupingExpr(std::unique_ptr<Expr> expr)
-            : expression(std::move(expr)) {}
+        explicit GroupingExpr(Expr* expr)
+            : Expr(ExprKind::GROUPING), expression(expr) {}
     
-        std::string toString() const override {
+        std::string toString() const {
             return "(group " + expression->toString() + ")";
         }
     };
@@ -92,100 +144,109 @@ class GroupingExpr : public Expr {
 
 class UnaryExpr : public Expr {
         public:
-            Token op;
-            std::unique_ptr<Expr> right;
+            TokenType op;  // MINUS or BANG
+            Expr* right;
         
-            UnaryExpr(Token op, std::unique_ptr<Expr> expr)
-                : op(op), right(std::move(expr)) {}
+            UnaryExpr(TokenType op, int line, Expr* expr)
+                : Expr(ExprKind::UNARY, line), op(op), right(expr) {}
         
-            std::string toString() const override {
-                return "(" + op.lexeme + " " + right->toString() + ")";
+            std::string toString() const {
+                return std::string(op == TokenType::MINUS ? "(-" : "(!") + " " + right->toString() + ")";
             }
         };
 
  class VariableExpr : public Expr {
     public:
-        std::string name;
+        Symbol name;
+        int depth = -1;  // Scopes to walk out, set by the Resolver (-1 means global)
+        int slot = -1;   // Index into that scope's slots
             
-        explicit VariableExpr(std::string name) : name(std::move(name)) {}
+        explicit VariableExpr(Symbol name) : Expr(ExprKind::VARIABLE), name(name) {}
             
-        std::string toString() const override {
-            return name;
+        std::string toString() const {
+            return std::string(symbolName(name));
         }
  };
 
  class AssignExpr : public Expr {
     public:
-        std::string name;
-        std::unique_ptr<Expr> value;
+        Symbol name;
+        Expr* value;
+        int depth = -1;  // Same addressing as VariableExpr
+        int slot = -1;
     
-        AssignExpr(std::string name, std::unique_ptr<Expr> value)
-            : name(std::move(name)), value(std::move(value)) {}
+        AssignExpr(Symbol name, Expr* value)
+            : Expr(ExprKind::ASSIGN), name(name), value(value) {}
     
-        std::string toString() const override {
-            return "(" + name + " = " + value->toString() + ")";
+        std::string toString() const {
+            return "(" + std::string(symbolName(name)) + " = " + value->toString() + ")";
         }
     };
 struct Stmt{
-    virtual ~Stmt()= default;
-    virtual std::string toString() const = 0;
+    const StmtKind kind;
+    int line = 0;  // Line the statement starts on
+
+    explicit Stmt(StmtKind kind) : kind(kind) {}
+    std::string toString() const;
 };
 
 struct PrintStmt : Stmt {
-    std::unique_ptr<Expr> expression;
-    PrintStmt(std::unique_ptr<Expr> expr) : expression(std::move(expr)) {}
-    std::string toString() const override {
+    Expr* expression;
+    PrintStmt(Expr* expr) : Stmt(StmtKind::PRINT), expression(expr) {}
+    std::string toString() const {
         return "(print " + expression->toString() + ")";
     }
 };
 
 class ExpressionStmt : public Stmt {
     public:
-        std::unique_ptr<Expr> expression;
+        Expr* expression;
     
-        ExpressionStmt(std::unique_ptr<Expr> expr) 
-            : expression(std::move(expr)) {}
+        ExpressionStmt(Expr* expr) 
+            : Stmt(StmtKind::EXPRESSION), expression(expr) {}
     
-        std::string toString() const override {
+        std::string toString() const {
             return  expression->toString() ;
          }
     };
 
     class VarDeclStmt : public Stmt {
         public:
-            std::string name;
-            std::unique_ptr<Expr> initializer;
+            Symbol name;
+            Expr* initializer;  // Can be nullptr
+            int slot = -1;  // Slot in the enclosing block, -1 for globals
         
-            VarDeclStmt(std::string name, std::unique_ptr<Expr> initializer)
-                : name(std::move(name)), initializer(std::move(initializer)) {}
+            VarDeclStmt(Symbol name, Expr* initializer)
+                : Stmt(StmtKind::VAR_DECL), name(name), initializer(initializer) {}
         
-            std::string toString() const override {
-                return "(var " + name + " = " + (initializer ? initializer->toString() : "nil") + ")";
+            std::string toString() const {
+                return "(var " + std::string(symbolName(name)) + " = " + (initializer ? initializer->toString() : "nil") + ")";
             }
         };
         
         // **Variable assignment (e.g., `x = 42;`)**
         class AssignStmt : public Stmt {
         public:
-            std::string name;
-            std::unique_ptr<Expr> value;
+            Symbol name;
+            Expr* value;
         
-            AssignStmt(std::string name, std::unique_ptr<Expr> value)
-                : name(std::move(name)), value(std::move(value)) {}
+            AssignStmt(Symbol name, Expr* value)
+                : Stmt(StmtKind::ASSIGN), name(name), value(value) {}
         
-            std::string toString() const override {
-                return "(" + name + " = " + value->toString() + ")";
+            std::string toString() const {
+                return "(" + std::string(symbolName(name)) + " = " + value->toString() + ")";
             }
         };
 
         class BlockStmt : public Stmt {
             public:
-                std::vector<std::unique_ptr<Stmt>> statements;
+                std::span<Stmt*> statements;  // Array stored in the arena
+                int slotCount = 0;  // Number of locals declared directly in this block
             
-                explicit BlockStmt(std::vector<std::unique_ptr<Stmt>> stmts)
-                    : statements(std::move(stmts)) {}
+                explicit BlockStmt(std::span<Stmt*> stmts)
+                    : Stmt(StmtKind::BLOCK), statements(stmts) {}
 
-                    std::string toString() const override {
+                    std::string toString() const {
                         return "BlockStmt";
                     }
             };
@@ -193,20 +254,20 @@ class ExpressionStmt : public Stmt {
 
             class IfStmt : public Stmt {
                 public:
-                    std::unique_ptr<Expr> condition;
-                    std::unique_ptr<Stmt> thenBranch;
-                    std::unique_ptr<Stmt> elseBranch;  // Can be nullptr
+                    Expr* condition;
+                    Stmt* thenBranch;
+                    Stmt* elseBranch;  // Can be nullptr
                     
-                    IfStmt(std::unique_ptr<Expr> condition, 
-                           std::unique_ptr<Stmt> thenBranch,
-                           std::unique_ptr<Stmt> elseBranch = nullptr)
-                        : condition(std::move(condition)),
-                          thenBranch(std::move(thenBranch)),
-                          elseBranch(std::move(elseBranch)) {}
+                    IfStmt(Expr* condition, 
+                           Stmt* thenBranch,
+                           Stmt* elseBranch = nullptr)
+                        : Stmt(StmtKind::IF), condition(condition),
+                          thenBranch(thenBranch),
+                          elseBranch(elseBranch) {}
 
                     
                     
-                        std::string toString() const override {
+                        std::string toString() const {
                             std::string result = "if (" + condition->toString() + ") " + thenBranch->toString();
                             if (elseBranch) {
                                 result += " else " + elseBranch->toString();
@@ -215,8 +276,59 @@ class ExpressionStmt : public Stmt {
                         }
                 };
 
+// The body's frame holds the parameters in slots 0..n-1, then its locals
+class FunctionStmt : public Stmt {
+public:
+    Symbol name;
+    std::span<Symbol> params;  // Array stored in the arena
+    BlockStmt* body;
+    int slot = -1;  // Same as VarDeclStmt: where the function is bound
+
+    FunctionStmt(Symbol name, std::span<Symbol> params, BlockStmt* body)
+        : Stmt(StmtKind::FUNCTION), name(name), params(params), body(body) {}
+
+    std::string toString() const {
+        std::string result = "(fun " + std::string(symbolName(name)) + "(";
+        for (size_t i = 0; i < params.size(); i++) {
+            result += (i ? ", " : "") + std::string(symbolName(params[i]));
+        }
+        return result + ") " + body->toString() + ")";
+    }
+};
+
+class ReturnStmt : public Stmt {
+public:
+    Expr* value;  // Can be nullptr
+
+    explicit ReturnStmt(Expr* value) : Stmt(StmtKind::RETURN), value(value) {}
+
+    std::string toString() const {
+        return value ? "(return " + value->toString() + ")" : "(return)";
+    }
+};
+
+// `while`, and the loop of a `for`: the parser wraps a `for` initializer
+// and this statement in a block, and keeps the increment here
+class WhileStmt : public Stmt {
+public:
+    Expr* condition;
+    Stmt* body;
+    Expr* increment;  // Can be nullptr; runs after each iteration of the body
+
+    WhileStmt(Expr* condition, Stmt* body, Expr* increment = nullptr)
+        : Stmt(StmtKind::WHILE), condition(condition), body(body), increment(increment) {}
+
+    std::string toString() const {
+        if (increment) {
+            return "for (; " + condition->toString() + "; " + increment->toString() + ") " + body->toString();
+        }
+        return "while (" + condition->toString() + ") " + body->toString();
+    }
+};
+
 struct Program {
-    std::vector<std::unique_ptr<Stmt>> statements;
+    Arena arena;  // Owns every node reachable from `statements`
+    std::vector<Stmt*> statements;
 
     std::string toString() const {
         std::ostringstream out;
@@ -228,5 +340,33 @@ struct Program {
 };
 
 
+inline std::string Expr::toString() const {
+    switch (kind) {
+        case ExprKind::LITERAL: return static_cast<const LiteralExpr*>(this)->toString();
+        case ExprKind::BINARY: return static_cast<const BinaryExpr*>(this)->toString();
+        case ExprKind::GROUPING: return static_cast<const GroupingExpr*>(this)->toString();
+        case ExprKind::UNARY: return static_cast<const UnaryExpr*>(this)->toString();
+        case ExprKind::VARIABLE: return static_cast<const VariableExpr*>(this)->toString();
+        case ExprKind::ASSIGN: return static_cast<const AssignExpr*>(this)->toString();
+        case ExprKind::LOGICAL: return static_cast<const LogicalExpr*>(this)->toString();
+        case ExprKind::CALL: return static_cast<const CallExpr*>(this)->toString();
+    }
+    return "Unknown";
+}
+
+inline std::string Stmt::toString() const {
+    switch (kind) {
+        case StmtKind::PRINT: return static_cast<const PrintStmt*>(this)->toString();
+        case StmtKind::EXPRESSION: return static_cast<const ExpressionStmt*>(this)->toString();
+        case StmtKind::VAR_DECL: return static_cast<const VarDeclStmt*>(this)->toString();
+        case StmtKind::ASSIGN: return static_cast<const AssignStmt*>(this)->toString();
+        case StmtKind::BLOCK: return static_cast<const BlockStmt*>(this)->toString();
+        case StmtKind::IF: return static_cast<const IfStmt*>(this)->toString();
+        case StmtKind::WHILE: return static_cast<const WhileStmt*>(this)->toString();
+        case StmtKind::FUNCTION: return static_cast<const FunctionStmt*>(this)->toString();
+        case StmtKind::RETURN: return static_cast<const ReturnStmt*>(this)->toString();
+    }
+    return "Unknown";
+}
 
 #endif // AST_H
\ No newline at end of file
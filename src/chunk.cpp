@@ -0,0 +1,39 @@
+#include "chunk.h"
+#include <algorithm>
+
+void Chunk::write(uint8_t byte, int line) {
+    if (lines.empty() || lines.back().line != line) {
+        lines.push_back({code.size(), line});
+    }
+    code.push_back(byte);
+}
+
+void Chunk::writeShort(uint16_t value, int line) {
+    write(static_cast<uint8_t>(value >> 8), line);
+    write(static_cast<uint8_t>(value & 0xff), line);
+}
+
+void Chunk::writeLong(uint32_t value, int line) {
+    write(static_cast<uint8_t>((value >> 16) & 0xff), line);
+    write(static_cast<uint8_t>((value >> 8) & 0xff), line);
+    write(static_cast<uint8_t>(value & 0xff), line);
+}
+
+void Chunk::patchLong(size_t offset, uint32_t value) {
+    code[offset] = static_cast<uint8_t>((value >> 16) & 0xff);
+    code[offset + 1] = static_cast<uint8_t>((value >> 8) & 0xff);
+    code[offset + 2] = static_cast<uint8_t>(value & 0xff);
+}
+
+size_t Chunk::addConstant(const Value& value) {
+    constants.push_back(value);
+    return constants.size() - 1;
+}
+
+int Chunk::getLine(size_t offset) const {
+    // Find the last line entry starting at or before the offset
+    auto it = std::upper_bound(lines.begin(), lines.end(), offset,
+                               [](size_t off, const LineStart& entry) { return off < entry.offset; });
+    if (it == lines.begin()) return 1;
+    return std::prev(it)->line;
+}
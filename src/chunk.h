@@ -0,0 +1,85 @@
+#ifndef CHUNK_H
+#define CHUNK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "symbol.h"
+#include "value.h"
+
+// Instruction set of the bytecode VM. Operands follow the opcode inline:
+//   constant/global/function indices and jump offsets are 24-bit, local
+//   slots and upvalue indices 16-bit, argument counts 8-bit. Local slots
+//   count from the current call's first argument.
+enum class OpCode : uint8_t {
+    CONSTANT,       // [u24 constant]
+    NIL,
+    TRUE,
+    FALSE,
+    POP,
+    POPN,           // [u16 count]
+    GET_LOCAL,      // [u16 slot]
+    SET_LOCAL,      // [u16 slot]
+    GET_UPVALUE,    // [u16 upvalue]
+    SET_UPVALUE,    // [u16 upvalue]
+    GET_GLOBAL,     // [u24 global]
+    DEFINE_GLOBAL,  // [u24 global]
+    SET_GLOBAL,     // [u24 global]
+    EQUAL,
+    NOT_EQUAL,
+    GREATER,
+    GREATER_EQUAL,
+    LESS,
+    LESS_EQUAL,
+    ADD,
+    SUBTRACT,
+    MULTIPLY,
+    DIVIDE,
+    NOT,
+    NEGATE,
+    PRINT,
+    JUMP,           // [u24 forward offset]
+    JUMP_IF_FALSE,  // [u24 forward offset], leaves the condition on the stack
+    LOOP,           // [u24 backward offset]
+    CLOSURE,        // [u24 function] then [u8 is local][u16 index] per upvalue
+    CLOSE_UPVALUE,  // Moves the top slot into the upvalue that captured it, then pops it
+    CHECK_CALL,     // [u8 arguments] fails before the arguments run if the callee can't take them
+    CALL,           // [u8 arguments]
+    TAIL_CALL,      // [u8 arguments] replaces the current call instead of nesting
+    RETURN          // Returns the top of the stack; ends the program outside a call
+};
+
+// A compiled `fun`. Its body is in the same chunk, starting at `entry`.
+struct FunctionProto {
+    Symbol name;
+    int arity;
+    size_t entry = 0;
+    uint16_t upvalueCount = 0;
+};
+
+class Chunk {
+public:
+    std::vector<uint8_t> code;
+    std::vector<Value> constants;
+    std::vector<std::string> globalNames;  // Indexed by the GET/SET/DEFINE_GLOBAL operand
+    std::vector<FunctionProto> functions;  // Indexed by the CLOSURE operand
+
+    void write(uint8_t byte, int line);
+    void writeOp(OpCode op, int line) { write(static_cast<uint8_t>(op), line); }
+    void writeShort(uint16_t value, int line);
+    void writeLong(uint32_t value, int line);
+    void patchLong(size_t offset, uint32_t value);
+
+    size_t addConstant(const Value& value);
+    int getLine(size_t offset) const;
+
+private:
+    // Run-length encoded line table: each entry is the first offset emitted for a line.
+    struct LineStart {
+        size_t offset;
+        int line;
+    };
+    std::vector<LineStart> lines;
+};
+
+#endif // CHUNK_H
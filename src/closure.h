@@ -0,0 +1,36 @@
+#ifndef CLOSURE_H
+#define CLOSURE_H
+
+#include <cstddef>
+#include <vector>
+#include "chunk.h"
+#include "value.h"
+
+// A variable a VM closure captured. While the call that declared it runs,
+// the value stays in its stack slot; when the slot goes away it is moved
+// into `closed`.
+struct Upvalue : Object {
+    size_t slot;
+    bool open = true;
+    Value closed;
+
+    explicit Upvalue(size_t slot) : Object(ObjectType::UPVALUE), slot(slot) {}
+
+    Value& value(std::vector<Value>& stack) { return open ? stack[slot] : closed; }
+};
+
+// The VM's function value: a compiled function and the variables it
+// captured, in the order of its GET/SET_UPVALUE operands. The function
+// lives in the chunk, which must outlive the closure.
+struct Closure : Object {
+    const FunctionProto* function;
+    std::vector<Upvalue*> upvalues;
+
+    explicit Closure(const FunctionProto* function) : Object(ObjectType::CLOSURE), function(function) {
+        upvalues.reserve(function->upvalueCount);
+    }
+};
+
+inline Closure& asClosure(const Value& value) { return *static_cast<Closure*>(value.object); }
+
+#endif // CLOSURE_H
@@ -0,0 +1,458 @@
+#include "compiler.h"
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+static constexpr uint32_t MAX_LONG_OPERAND = 0xffffff;
+static constexpr size_t MAX_LOCALS = 0x10000;
+static constexpr size_t MAX_UPVALUES = 0x10000;
+
+std::unique_ptr<Chunk> Compiler::compile(const std::unique_ptr<Program>& program) {
+    auto result = std::make_unique<Chunk>();
+    chunk = result.get();
+
+    for (const auto& stmt : program->statements) {
+        compileStmt(stmt);
+    }
+    emit(OpCode::RETURN);
+
+    chunk = nullptr;
+    return result;
+}
+
+void Compiler::compileStmt(Stmt* stmt) {
+    switch (stmt->kind) {
+        case StmtKind::PRINT:
+            compileExpr(static_cast<PrintStmt*>(stmt)->expression);
+            emit(OpCode::PRINT);
+            break;
+        case StmtKind::EXPRESSION:
+            compileExpr(static_cast<ExpressionStmt*>(stmt)->expression);
+            emit(OpCode::POP);
+            break;
+        case StmtKind::VAR_DECL: compileVarDecl(static_cast<VarDeclStmt*>(stmt)); break;
+        case StmtKind::BLOCK: compileBlock(static_cast<BlockStmt*>(stmt)); break;
+        case StmtKind::IF: compileIf(static_cast<IfStmt*>(stmt)); break;
+        case StmtKind::WHILE: compileWhile(static_cast<WhileStmt*>(stmt)); break;
+        case StmtKind::FUNCTION: compileFunction(static_cast<FunctionStmt*>(stmt)); break;
+        case StmtKind::RETURN: compileReturn(static_cast<ReturnStmt*>(stmt)); break;
+        default:
+            throw std::runtime_error("Unknown statement type.");
+    }
+}
+
+void Compiler::compileVarDecl(VarDeclStmt* stmt) {
+    if (stmt->initializer) {
+        compileExpr(stmt->initializer);
+    } else {
+        emit(OpCode::NIL);
+    }
+
+    if (current->scopeDepth == 0) {
+        emitWithLong(OpCode::DEFINE_GLOBAL, globalSlot(stmt->name));
+        return;
+    }
+
+    // Redeclaring a name in the same block overwrites the existing slot
+    int slot = declaredInScope(stmt->name);
+    if (slot != -1) {
+        emitWithShort(OpCode::SET_LOCAL, static_cast<uint16_t>(slot));
+        emit(OpCode::POP);
+        return;
+    }
+    // The initializer's value stays on the stack and becomes the local's slot
+    addLocal(stmt->name);
+}
+
+// The closure is made where the declaration runs and bound like a `var`
+void Compiler::compileFunction(FunctionStmt* stmt) {
+    line = stmt->line;
+    // A local is declared before the body so the function can refer to itself
+    int slot = -1;
+    if (current->scopeDepth > 0) {
+        slot = declaredInScope(stmt->name);
+        if (slot == -1) addLocal(stmt->name);
+    }
+
+    size_t index = chunk->functions.size();
+    if (index > MAX_LONG_OPERAND) {
+        error("Too many functions.");
+    }
+    chunk->functions.push_back({stmt->name, static_cast<int>(stmt->params.size())});
+    size_t skip = emitJump(OpCode::JUMP);
+    chunk->functions[index].entry = chunk->code.size();
+
+    // Parameters take the first slots of the body's scope
+    FunctionScope function;
+    function.enclosing = current;
+    function.scopeDepth = 1;
+    current = &function;
+    for (Symbol param : stmt->params) {
+        addLocal(param);
+    }
+    for (Stmt* statement : stmt->body->statements) {
+        compileStmt(statement);
+    }
+    emit(OpCode::NIL);
+    emit(OpCode::RETURN);  // Also closes whatever the body's locals were captured in
+    current = function.enclosing;
+    patchJump(skip);
+
+    line = stmt->line;
+    chunk->functions[index].upvalueCount = static_cast<uint16_t>(function.upvalues.size());
+    emitWithLong(OpCode::CLOSURE, static_cast<uint32_t>(index));
+    for (const UpvalueRef& upvalue : function.upvalues) {
+        chunk->write(upvalue.isLocal ? 1 : 0, line);
+        chunk->writeShort(upvalue.index, line);
+    }
+
+    if (current->scopeDepth == 0) {
+        emitWithLong(OpCode::DEFINE_GLOBAL, globalSlot(stmt->name));
+    } else if (slot != -1) {
+        emitWithShort(OpCode::SET_LOCAL, static_cast<uint16_t>(slot));
+        emit(OpCode::POP);
+    }
+}
+
+// `return f(...)` runs f in place of the current call, as the Evaluator does,
+// so tail recursion is not limited by the call depth
+void Compiler::compileReturn(ReturnStmt* stmt) {
+    line = stmt->line;
+    if (stmt->value && stmt->value->kind == ExprKind::CALL) {
+        compileCall(static_cast<CallExpr*>(stmt->value), true);
+        return;
+    }
+    if (stmt->value) {
+        compileExpr(stmt->value);
+    } else {
+        emit(OpCode::NIL);
+    }
+    emit(OpCode::RETURN);
+}
+
+// The callee is checked before the arguments run, matching the Evaluator's
+// order of side effects and errors
+void Compiler::compileCall(CallExpr* expr, bool tail) {
+    compileExpr(expr->callee);
+    line = expr->line;
+    auto count = static_cast<uint8_t>(expr->arguments.size());  // The parser allows at most 255
+    emitWithByte(OpCode::CHECK_CALL, count);
+    for (Expr* argument : expr->arguments) {
+        compileExpr(argument);
+    }
+    line = expr->line;
+    emitWithByte(tail ? OpCode::TAIL_CALL : OpCode::CALL, count);
+}
+
+void Compiler::compileBlock(BlockStmt* stmt) {
+    beginScope();
+    for (const auto& statement : stmt->statements) {
+        compileStmt(statement);
+    }
+    endScope();
+}
+
+void Compiler::compileIf(IfStmt* stmt) {
+    compileExpr(stmt->condition);
+
+    size_t thenJump = emitJump(OpCode::JUMP_IF_FALSE);
+    emit(OpCode::POP);
+    compileStmt(stmt->thenBranch);
+
+    size_t elseJump = emitJump(OpCode::JUMP);
+    patchJump(thenJump);
+    emit(OpCode::POP);
+    if (stmt->elseBranch) {
+        compileStmt(stmt->elseBranch);
+    }
+    patchJump(elseJump);
+}
+
+void Compiler::compileWhile(WhileStmt* stmt) {
+    size_t loopStart = chunk->code.size();
+    compileExpr(stmt->condition);
+
+    size_t exitJump = emitJump(OpCode::JUMP_IF_FALSE);
+    emit(OpCode::POP);
+    compileStmt(stmt->body);
+    if (stmt->increment) {
+        compileExpr(stmt->increment);
+        emit(OpCode::POP);
+    }
+    line = stmt->line;
+    emitLoop(loopStart);
+
+    patchJump(exitJump);
+    emit(OpCode::POP);
+}
+
+void Compiler::compileExpr(Expr* expr) {
+    switch (expr->kind) {
+        case ExprKind::BINARY:
+            compileBinary(static_cast<BinaryExpr*>(expr));
+            break;
+        case ExprKind::LOGICAL:
+            compileLogical(static_cast<LogicalExpr*>(expr));
+            break;
+        case ExprKind::CALL:
+            compileCall(static_cast<CallExpr*>(expr), false);
+            break;
+        case ExprKind::LITERAL: {
+            const Value& value = static_cast<LiteralExpr*>(expr)->value;
+            if (value.isNil()) emit(OpCode::NIL);
+            else if (value.isBool()) emit(value.boolean ? OpCode::TRUE : OpCode::FALSE);
+            else emitWithLong(OpCode::CONSTANT, makeConstant(value));
+            break;
+        }
+        case ExprKind::UNARY: {
+            auto unary = static_cast<UnaryExpr*>(expr);
+            compileExpr(unary->right);
+            line = unary->line;
+            if (unary->op == TokenType::MINUS) emit(OpCode::NEGATE);
+            else if (unary->op == TokenType::BANG) emit(OpCode::NOT);
+            else throw std::runtime_error("Unsupported unary operator.");
+            break;
+        }
+        case ExprKind::GROUPING:
+            compileExpr(static_cast<GroupingExpr*>(expr)->expression);
+            break;
+        case ExprKind::VARIABLE:
+            compileGet(static_cast<VariableExpr*>(expr)->name);
+            break;
+        case ExprKind::ASSIGN: {
+            auto assignExpr = static_cast<AssignExpr*>(expr);
+            compileExpr(assignExpr->value);
+            compileSet(assignExpr->name);
+            break;
+        }
+    }
+}
+
+void Compiler::compileBinary(BinaryExpr* expr) {
+    compileExpr(expr->left);
+    compileExpr(expr->right);
+    line = expr->line;
+
+    switch (expr->op) {
+        case BinaryOp::ADD: emit(OpCode::ADD); break;
+        case BinaryOp::SUBTRACT: emit(OpCode::SUBTRACT); break;
+        case BinaryOp::MULTIPLY: emit(OpCode::MULTIPLY); break;
+        case BinaryOp::DIVIDE: emit(OpCode::DIVIDE); break;
+        case BinaryOp::EQUAL: emit(OpCode::EQUAL); break;
+        case BinaryOp::NOT_EQUAL: emit(OpCode::NOT_EQUAL); break;
+        case BinaryOp::GREATER: emit(OpCode::GREATER); break;
+        case BinaryOp::GREATER_EQUAL: emit(OpCode::GREATER_EQUAL); break;
+        case BinaryOp::LESS: emit(OpCode::LESS); break;
+        case BinaryOp::LESS_EQUAL: emit(OpCode::LESS_EQUAL); break;
+    }
+}
+
+// The left operand stays on the stack as the result when it decides it
+void Compiler::compileLogical(LogicalExpr* expr) {
+    compileExpr(expr->left);
+    line = expr->line;
+
+    size_t endJump;
+    if (expr->isAnd) {
+        endJump = emitJump(OpCode::JUMP_IF_FALSE);
+    } else {
+        size_t elseJump = emitJump(OpCode::JUMP_IF_FALSE);
+        endJump = emitJump(OpCode::JUMP);
+        patchJump(elseJump);
+    }
+    emit(OpCode::POP);
+    compileExpr(expr->right);
+    patchJump(endJump);
+}
+
+void Compiler::compileGet(Symbol name) {
+    int slot = resolveLocal(*current, name);
+    if (slot != -1) {
+        emitWithShort(OpCode::GET_LOCAL, static_cast<uint16_t>(slot));
+    } else if ((slot = resolveUpvalue(*current, name)) != -1) {
+        emitWithShort(OpCode::GET_UPVALUE, static_cast<uint16_t>(slot));
+    } else {
+        emitWithLong(OpCode::GET_GLOBAL, globalSlot(name));
+    }
+}
+
+void Compiler::compileSet(Symbol name) {
+    int slot = resolveLocal(*current, name);
+    if (slot != -1) {
+        emitWithShort(OpCode::SET_LOCAL, static_cast<uint16_t>(slot));
+    } else if ((slot = resolveUpvalue(*current, name)) != -1) {
+        emitWithShort(OpCode::SET_UPVALUE, static_cast<uint16_t>(slot));
+    } else {
+        emitWithLong(OpCode::SET_GLOBAL, globalSlot(name));
+    }
+}
+
+void Compiler::beginScope() {
+    current->scopeDepth++;
+}
+
+// Captured locals are closed one at a time; runs of the others are popped together
+void Compiler::endScope() {
+    current->scopeDepth--;
+
+    std::vector<Local>& locals = current->locals;
+    size_t count = 0;
+    while (!locals.empty() && locals.back().depth > current->scopeDepth) {
+        if (locals.back().captured) {
+            emitPops(count);
+            count = 0;
+            emit(OpCode::CLOSE_UPVALUE);
+        } else {
+            count++;
+        }
+        locals.pop_back();
+    }
+    emitPops(count);
+}
+
+void Compiler::emitPops(size_t count) {
+    if (count == 1) {
+        emit(OpCode::POP);
+    } else if (count > 1) {
+        emitWithShort(OpCode::POPN, static_cast<uint16_t>(count));
+    }
+}
+
+// Slot of `name` if the innermost block already declares it, else -1
+int Compiler::declaredInScope(Symbol name) {
+    const std::vector<Local>& locals = current->locals;
+    for (int i = static_cast<int>(locals.size()) - 1; i >= 0 && locals[i].depth == current->scopeDepth; i--) {
+        if (locals[i].name == name) return i;
+    }
+    return -1;
+}
+
+void Compiler::addLocal(Symbol name) {
+    if (current->locals.size() >= MAX_LOCALS) {
+        error("Too many local variables in scope.");
+    }
+    current->locals.push_back({name, current->scopeDepth});
+}
+
+int Compiler::resolveLocal(const FunctionScope& scope, Symbol name) {
+    for (int i = static_cast<int>(scope.locals.size()) - 1; i >= 0; i--) {
+        if (scope.locals[i].name == name) return i;
+    }
+    return -1;
+}
+
+// Finds `name` in the enclosing functions, threading an upvalue through
+// each function in between; -1 if it is a global
+int Compiler::resolveUpvalue(FunctionScope& scope, Symbol name) {
+    if (scope.enclosing == nullptr) return -1;
+
+    int local = resolveLocal(*scope.enclosing, name);
+    if (local != -1) {
+        scope.enclosing->locals[local].captured = true;
+        return addUpvalue(scope, true, local);
+    }
+    int upvalue = resolveUpvalue(*scope.enclosing, name);
+    if (upvalue != -1) {
+        return addUpvalue(scope, false, upvalue);
+    }
+    return -1;
+}
+
+int Compiler::addUpvalue(FunctionScope& scope, bool isLocal, int index) {
+    for (size_t i = 0; i < scope.upvalues.size(); i++) {
+        if (scope.upvalues[i].isLocal == isLocal && scope.upvalues[i].index == index) {
+            return static_cast<int>(i);
+        }
+    }
+    if (scope.upvalues.size() >= MAX_UPVALUES) {
+        error("Too many closure variables in function.");
+    }
+    scope.upvalues.push_back({isLocal, static_cast<uint16_t>(index)});
+    return static_cast<int>(scope.upvalues.size() - 1);
+}
+
+uint32_t Compiler::globalSlot(Symbol name) {
+    auto it = globalSlots.find(name);
+    if (it != globalSlots.end()) return it->second;
+
+    if (chunk->globalNames.size() > MAX_LONG_OPERAND) {
+        error("Too many global variables.");
+    }
+    uint32_t slot = static_cast<uint32_t>(chunk->globalNames.size());
+    chunk->globalNames.emplace_back(symbolName(name));
+    globalSlots.emplace(name, slot);
+    return slot;
+}
+
+uint32_t Compiler::makeConstant(const Value& value) {
+    // Identical literals share one constant pool entry
+    if (value.isNumber()) {
+        uint64_t bits;
+        std::memcpy(&bits, &value.number, sizeof bits);
+        auto it = numberConstants.find(bits);
+        if (it != numberConstants.end()) return it->second;
+    } else if (value.isString()) {
+        auto it = stringConstants.find(std::string(value.asString()));
+        if (it != stringConstants.end()) return it->second;
+    }
+
+    size_t index = chunk->addConstant(value);
+    if (index > MAX_LONG_OPERAND) {
+        error("Too many constants in one chunk.");
+    }
+
+    if (value.isNumber()) {
+        uint64_t bits;
+        std::memcpy(&bits, &value.number, sizeof bits);
+        numberConstants.emplace(bits, static_cast<uint32_t>(index));
+    } else if (value.isString()) {
+        stringConstants.emplace(std::string(value.asString()), static_cast<uint32_t>(index));
+    }
+    return static_cast<uint32_t>(index);
+}
+
+void Compiler::emit(OpCode op) {
+    chunk->writeOp(op, line);
+}
+
+void Compiler::emitWithLong(OpCode op, uint32_t operand) {
+    chunk->writeOp(op, line);
+    chunk->writeLong(operand, line);
+}
+
+void Compiler::emitWithShort(OpCode op, uint16_t operand) {
+    chunk->writeOp(op, line);
+    chunk->writeShort(operand, line);
+}
+
+void Compiler::emitWithByte(OpCode op, uint8_t operand) {
+    chunk->writeOp(op, line);
+    chunk->write(operand, line);
+}
+
+// Emits a jump with a placeholder operand and returns the operand's offset
+size_t Compiler::emitJump(OpCode op) {
+    emitWithLong(op, MAX_LONG_OPERAND);
+    return chunk->code.size() - 3;
+}
+
+void Compiler::patchJump(size_t operandOffset) {
+    size_t distance = chunk->code.size() - (operandOffset + 3);
+    if (distance > MAX_LONG_OPERAND) {
+        error("Too much code to jump over.");
+    }
+    chunk->patchLong(operandOffset, static_cast<uint32_t>(distance));
+}
+
+void Compiler::emitLoop(size_t loopStart) {
+    size_t distance = chunk->code.size() + 4 - loopStart;  // Includes the LOOP instruction itself
+    if (distance > MAX_LONG_OPERAND) {
+        error("Loop body too large.");
+    }
+    emitWithLong(OpCode::LOOP, static_cast<uint32_t>(distance));
+}
+
+void Compiler::error(const std::string& message) {
+    std::cerr << "[line " << line << "] Error: " << message << std::endl;
+    exit(65);
+}
@@ -0,0 +1,82 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+#include "chunk.h"
+
+// Lowers a parsed Program into a single bytecode Chunk for the VM.
+// Globals are resolved to indices at compile time, locals to stack slots in
+// their call's frame, and locals of enclosing functions to upvalues. A
+// function's body is compiled where it is declared, behind a jump.
+class Compiler {
+public:
+    std::unique_ptr<Chunk> compile(const std::unique_ptr<Program>& program);
+
+private:
+    struct Local {
+        Symbol name;
+        int depth;
+        bool captured = false;  // Closed over, so its slot is closed rather than popped
+    };
+    struct UpvalueRef {
+        bool isLocal;    // A local of the enclosing function, or one of its upvalues
+        uint16_t index;
+    };
+    // What is being compiled: the script, or a function nested in it
+    struct FunctionScope {
+        FunctionScope* enclosing = nullptr;
+        std::vector<Local> locals;
+        std::vector<UpvalueRef> upvalues;
+        int scopeDepth = 0;
+    };
+
+    Chunk* chunk = nullptr;
+    FunctionScope script;
+    FunctionScope* current = &script;
+    int line = 1;  // Last source line seen, recorded in the chunk's line table
+    std::unordered_map<Symbol, uint32_t> globalSlots;
+    std::unordered_map<uint64_t, uint32_t> numberConstants;  // Keyed by bit pattern so -0.0 stays distinct
+    std::unordered_map<std::string, uint32_t> stringConstants;
+
+    void compileStmt(Stmt* stmt);
+    void compileExpr(Expr* expr);
+    void compileBinary(BinaryExpr* expr);
+    void compileLogical(LogicalExpr* expr);
+    void compileVarDecl(VarDeclStmt* stmt);
+    void compileBlock(BlockStmt* stmt);
+    void compileIf(IfStmt* stmt);
+    void compileWhile(WhileStmt* stmt);
+    void compileFunction(FunctionStmt* stmt);
+    void compileReturn(ReturnStmt* stmt);
+    void compileCall(CallExpr* expr, bool tail);
+    void compileGet(Symbol name);
+    void compileSet(Symbol name);
+
+    void beginScope();
+    void endScope();
+    void emitPops(size_t count);
+    int declaredInScope(Symbol name);
+    void addLocal(Symbol name);
+    int resolveLocal(const FunctionScope& scope, Symbol name);
+    int resolveUpvalue(FunctionScope& scope, Symbol name);
+    int addUpvalue(FunctionScope& scope, bool isLocal, int index);
+    uint32_t globalSlot(Symbol name);
+    uint32_t makeConstant(const Value& value);
+
+    void emit(OpCode op);
+    void emitWithLong(OpCode op, uint32_t operand);
+    void emitWithShort(OpCode op, uint16_t operand);
+    void emitWithByte(OpCode op, uint8_t operand);
+    size_t emitJump(OpCode op);
+    void patchJump(size_t operandOffset);
+    void emitLoop(size_t loopStart);
+    void error(const std::string& message);
+};
+
+#endif // COMPILER_H
@@ -1,14 +1,32 @@
 #include "environment.h"
+#include "allocation.h"
 #include <stdexcept>
 
-Environment::Environment(std::shared_ptr<Environment> parent)
-    : enclosing(parent) {}
+Environment::Environment(Environment* parent, size_t slotCount)
+    : Object(ObjectType::ENVIRONMENT), enclosing(parent), slots(slotCount) {}
 
-void Environment::define(const std::string& name, const std::string& value) {
-    values[name] = value;
+void Environment::reuse(Environment* parent, size_t slotCount) {
+    enclosing = parent;
+    slots.resize(slotCount);
 }
 
-std::string Environment::get(const std::string& name, int line) {
+void Environment::release() {
+    enclosing = nullptr;
+    slots.clear();  // Nothing is kept alive through it now; the capacity stays
+    values.clear();
+}
+
+void Environment::define(Symbol name, const Value& value) {
+    auto it = values.find(name);
+    if (it != values.end()) {
+        it->second = value;
+        return;
+    }
+    MemoryScope memory(MemoryTag::ENVIRONMENTS);
+    values.emplace(name, value);
+}
+
+const Value& Environment::get(Symbol name, int line) {
     auto it = values.find(name);
     if (it != values.end()) {
         return it->second;
@@ -18,14 +36,14 @@ std::string Environment::get(const std::string& name, int line) {
         return enclosing->get(name, line);
     }
     
-    throw std::runtime_error("Undefined variable '" + name + 
+    throw std::runtime_error("Undefined variable '" + std::string(symbolName(name)) + 
                            (line != -1 ? "' at line " + std::to_string(line) : "'"));
 }
 
-void Environment::assign(const std::string& name, const std::string& value, int line) {
+void Environment::assign(Symbol name, const Value& value, int line) {
     auto it = values.find(name);
     if (it != values.end()) {
-        values[name] = value;
+        it->second = value;
         return;
     }
     
@@ -34,6 +52,14 @@ void Environment::assign(const std::string& name, const std::string& value, int
         return;
     }
     
-    throw std::runtime_error("Undefined variable '" + name + 
+    throw std::runtime_error("Undefined variable '" + std::string(symbolName(name)) + 
                            (line != -1 ? "' at line " + std::to_string(line) : "'"));
-}
\ No newline at end of file
+}
+
+Environment* Environment::ancestor(int depth) {
+    Environment* env = this;
+    for (int i = 0; i < depth; i++) {
+        env = env->enclosing;
+    }
+    return env;
+}
@@ -3,21 +3,38 @@
 
 #include <unordered_map>
 #include <string>
-#include <memory>
+#include <string_view>
 #include <stdexcept>
+#include <vector>
+#include "symbol.h"
+#include "value.h"
 
-class Environment {
+// A scope's variables. Made by the evaluator's Heap, which frees it once
+// nothing reaches it; `enclosing` is the scope it was opened in.
+class Environment : public Object {
 public:
-    std::shared_ptr<Environment> enclosing;
-    
-    Environment(std::shared_ptr<Environment> parent = nullptr);
+    Environment* enclosing;
+    std::vector<Value> slots;  // Block locals, addressed by the Resolver's slot numbers
+    bool captured = false;  // A closure refers to it, so it outlives its block
 
-    void define(const std::string& name, const std::string& value);
-    std::string get(const std::string& name, int line = -1);  // Added line parameter
-    void assign(const std::string& name, const std::string& value, int line = -1);  // Added line parameter
+    Environment(Environment* parent = nullptr, size_t slotCount = 0);
+
+    // Pooled frames: reuse() readies a frame for another block execution,
+    // keeping the slot storage; release() drops everything it refers to
+    void reuse(Environment* parent, size_t slotCount);
+    void release();
+
+    // Name-based access, used for globals
+    void define(Symbol name, const Value& value);
+    const Value& get(Symbol name, int line = -1);  // Added line parameter
+    void assign(Symbol name, const Value& value, int line = -1);  // Added line parameter
+
+    Environment* ancestor(int depth);
+    Value& slotAt(int depth, int slot) { return ancestor(depth)->slots[slot]; }
 
 private:
-    std::unordered_map<std::string, std::string> values;
+    friend class Heap;  // Traces and sizes `values`
+    std::unordered_map<Symbol, Value> values;  // Symbols are small integers: hashing is free
 };
 
-#endif
\ No newline at end of file
+#endif
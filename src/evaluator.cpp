@@ -1,67 +1,81 @@
 #include "evaluator.h"
 #include "environment.h"
+#include "allocation.h"
+#include "function.h"
 #include <stdexcept>
 #include <cctype>
 #include <cmath>
+#include <utility>
+#include <pthread.h>
+
+namespace {
+
+// Lowest address of the calling thread's stack, or nullptr if unknown
+const char* stackBottom() {
+    pthread_attr_t attributes;
+    if (pthread_getattr_np(pthread_self(), &attributes) != 0) return nullptr;
+    void* bottom = nullptr;
+    size_t size = 0;
+    int status = pthread_attr_getstack(&attributes, &bottom, &size);
+    pthread_attr_destroy(&attributes);
+    return status == 0 ? static_cast<const char*>(bottom) : nullptr;
+}
+
+}  // namespace
 
 // complex data types 
 Evaluator::Evaluator(bool isEvaluatedMode) : isEvaluatedMode(isEvaluatedMode) {
-    globals = std::make_shared<Environment>();
+    MemoryScope memory(MemoryTag::ENVIRONMENTS);
+    globals = heap.make<Environment>();
     environment = globals;
+    if (const char* bottom = stackBottom()) {
+        stackLimit = bottom + STACK_RESERVE;  // Runs on the thread that made it
+    }
 }
 
-std::string formatNumbers( const std::string &str){
-    try
-    {
-        size_t pos;
-        double num= std::stod(str,&pos);
-        if(pos!=str.size()){
-            return str;
-        }
-
-
-        if(num== static_cast<int>(num)){
-            return std::to_string(static_cast<int>(num));
-        }
-
-        std::ostringstream out;
-        out<<std::fixed<<std::setprecision(6)<<num;
-        std::string formatted= out.str();
-
-        formatted.erase(formatted.find_last_not_of('0') + 1, std::string::npos);
-        if (formatted.back() == '.') formatted.pop_back();
-        return formatted;
+// Profiling costs one predictable branch per node when it is off
+void Evaluator::evaluateStmt(Stmt* node) {
+    if (profiler) [[unlikely]] {
+        profileStmt(node);
+    } else {
+        dispatchStmt(node);
     }
-    catch(const std::invalid_argument&)
-    {
-        return str;
+    // Between statements, every live object is reachable from the roots
+    if (heap.shouldCollect()) [[unlikely]] {
+        collectGarbage();
     }
-    
 }
 
-std::string Evaluator::evaluate(std::unique_ptr<Expr>& expr) {
-    return evaluateExpr(expr.get()).value;
+void Evaluator::collectGarbage() {
+    heap.collect([this](Heap& heap) {
+        heap.mark(globals);
+        heap.mark(environment);
+        for (Environment* frame : frameRoots) heap.mark(frame);
+        for (Environment* frame : framePool) heap.mark(frame);
+        heap.mark(tailCall.frame);
+        for (const Value& value : temporaries) heap.mark(value);
+        heap.mark(returnValue);
+    });
 }
 
+void Evaluator::profileStmt(Stmt* node) {
+    auto start = profiler->enter();
+    dispatchStmt(node);
+    profiler->leave(start, node->line, Profiler::key(node->kind));
+}
 
-void Evaluator::evaluateStmt( const std::unique_ptr<Stmt>& stmt) {
-    if (auto printStmt = dynamic_cast<PrintStmt*>(stmt.get())) {
-        evaluatePrint(printStmt);
-    }
-    else if(auto expressionStmt= dynamic_cast<ExpressionStmt*>(stmt.get())){
-        evaluateExpression(expressionStmt);
-    }
-    else if (auto varStmt = dynamic_cast<VarDeclStmt*>(stmt.get())) {
-        evaluateVariable(varStmt);
-    }
-    else if (auto blockStmt = dynamic_cast<BlockStmt *>(stmt.get())) {
-        evaluateBlock(blockStmt);}
-
-    else if (auto ifStmt = dynamic_cast<IfStmt*>(stmt.get())) {
-            evaluateIf(ifStmt);
-        }
-    else {
-        throw std::runtime_error("Unknown statement type.");
+void Evaluator::dispatchStmt(Stmt* node) {
+    switch (node->kind) {
+        case StmtKind::PRINT: evaluatePrint(static_cast<PrintStmt*>(node)); break;
+        case StmtKind::EXPRESSION: evaluateExpression(static_cast<ExpressionStmt*>(node)); break;
+        case StmtKind::VAR_DECL: evaluateVariable(static_cast<VarDeclStmt*>(node)); break;
+        case StmtKind::BLOCK: evaluateBlock(static_cast<BlockStmt*>(node)); break;
+        case StmtKind::IF: evaluateIf(static_cast<IfStmt*>(node)); break;
+        case StmtKind::WHILE: evaluateWhile(static_cast<WhileStmt*>(node)); break;
+        case StmtKind::FUNCTION: evaluateFunction(static_cast<FunctionStmt*>(node)); break;
+        case StmtKind::RETURN: evaluateReturn(static_cast<ReturnStmt*>(node)); break;
+        default:
+            throw std::runtime_error("Unknown statement type.");
     }
 }
 void Evaluator::evaluateProgram(const std::unique_ptr<Program>& program) {
@@ -71,21 +85,7 @@ void Evaluator::evaluateProgram(const std::unique_ptr<Program>& program) {
 }
 
 void Evaluator::evaluateIf(IfStmt* stmt) {
-    Evalstr condition = evaluateExpr(stmt->condition.get());
-    
-    // Convert condition to boolean
-    bool isTruthy = false;
-    if (condition.datatype == "bool") {
-        isTruthy = (condition.value == "true");
-    } else if (condition.datatype == "nil") {
-        isTruthy = false;
-    } else if (condition.datatype == "double") {
-        isTruthy = (std::stod(condition.value) != 0.0);
-    } else { // strings and others
-        isTruthy = true;
-    }
-
-    if (isTruthy) {
+    if (evaluateCondition(stmt->condition)) {
         evaluateStmt(stmt->thenBranch);
     } else if (stmt->elseBranch != nullptr) {
         evaluateStmt(stmt->elseBranch);
@@ -93,220 +93,359 @@ void Evaluator::evaluateIf(IfStmt* stmt) {
 }
 
 void Evaluator::evaluateBlock(BlockStmt *stmt) {
-    // Save the current environment
-    auto previous = environment;
-    
-    // Create a new nested environment
-    environment = std::make_shared<Environment>(previous);
-    
+    // Enter a nested environment, reusing a pooled frame when one is free
+    Environment* frame = acquireFrame(stmt->slotCount, environment);
+    executeBlock(stmt, frame);
+    releaseFrame(frame);
+}
+
+void Evaluator::executeBlock(BlockStmt* stmt, Environment* frame) {
+    // Save the current environment; it stays a root while the block runs
+    frameRoots.push_back(environment);
+    environment = frame;
+
     try {
         for (const auto &statement : stmt->statements) {
             evaluateStmt(statement);
+            if (returning) break;
         }
     } catch (...) {
-        environment = previous;  // Restore previous environment on error
+        environment = frameRoots.back();  // Restore previous environment on error
+        frameRoots.pop_back();
         throw;
     }
 
     // Restore the previous environment after execution
-    environment = previous;
+    environment = frameRoots.back();
+    frameRoots.pop_back();
+}
+
+void Evaluator::evaluateWhile(WhileStmt* stmt) {
+    if (stmt->body->kind != StmtKind::BLOCK) {
+        while (evaluateCondition(stmt->condition)) {
+            evaluateStmt(stmt->body);
+            if (returning) break;
+            if (stmt->increment) evaluateExpr(stmt->increment);
+        }
+        return;
+    }
+
+    // Every iteration declares its locals afresh, so one frame serves them
+    // all; a new one is only taken if a closure captured the last one
+    auto body = static_cast<BlockStmt*>(stmt->body);
+    Environment* frame = nullptr;
+    frameRoots.push_back(nullptr);  // The frame, while the condition and increment run
+    while (evaluateCondition(stmt->condition)) {
+        if (!frame) {
+            frame = acquireFrame(body->slotCount, environment);
+            frameRoots.back() = frame;
+        }
+        executeBlock(body, frame);
+        if (frame->captured) frame = nullptr;
+        if (returning) break;
+        if (stmt->increment) evaluateExpr(stmt->increment);
+    }
+    frameRoots.pop_back();
+    if (frame) releaseFrame(frame);
+}
+
+Environment* Evaluator::acquireFrame(size_t slotCount, Environment* parent) {
+    if (framePool.empty()) {
+        MemoryScope memory(MemoryTag::ENVIRONMENTS);
+        return heap.make<Environment>(parent, slotCount);
+    }
+    Environment* frame = framePool.back();
+    framePool.pop_back();
+    frame->reuse(parent, slotCount);
+    return frame;
+}
+
+// The function closes over the current frame, which then outlives its
+// block, and so do the frames it is nested in
+void Evaluator::evaluateFunction(FunctionStmt* stmt) {
+    Value function;
+    {
+        MemoryScope memory(MemoryTag::FUNCTIONS);
+        function = Value(ValueType::FUNCTION, heap.make<Function>(stmt, environment));
+    }
+    for (Environment* scope = environment; scope && !scope->captured; scope = scope->enclosing) {
+        scope->captured = true;
+    }
+    createdFunction = true;
+
+    if (stmt->slot >= 0) {
+        environment->slots[stmt->slot] = std::move(function);
+    } else {
+        environment->define(stmt->name, function);
+    }
+}
+
+// A call in tail position isn't made here: its frame is handed back to the
+// enclosing evaluateCall, which runs it instead of nesting another call
+void Evaluator::evaluateReturn(ReturnStmt* stmt) {
+    if (stmt->value && stmt->value->kind == ExprKind::CALL) {
+        tailCall = prepareCall(static_cast<CallExpr*>(stmt->value));
+        returnValue = Value();
+    } else {
+        returnValue = stmt->value ? evaluateExpr(stmt->value) : Value();
+    }
+    returning = true;
+}
+
+// A captured frame must outlive its block, so it is left to the collector,
+// as are frames the full pool has no room for
+void Evaluator::releaseFrame(Environment* frame) {
+    if (frame->captured || framePool.size() >= MAX_POOLED_FRAMES) return;
+    frame->release();
+    framePool.push_back(frame);
 }
 
 
 void Evaluator::evaluateExpression(ExpressionStmt *stmt){
-    Evalstr result=evaluateExpr(stmt->expression.get());
+    Value result=evaluateExpr(stmt->expression);
     if(isEvaluatedMode){
-        std::cout<<result.value<<std::endl;
+        printValue(std::cout, result);
     }
 }
 
 void Evaluator::evaluatePrint(PrintStmt* stmt) {
-    Evalstr result = evaluateExpr(stmt->expression.get());
-    std::cout << result.value << std::endl;
+    Value result = evaluateExpr(stmt->expression);
+    printValue(std::cout, result);
 }
 void Evaluator::evaluateVariable(VarDeclStmt* stmt) {
-    if(stmt->initializer.get()==nullptr){
-        environment->define(stmt->name, "nil");
+    Value value;
+    if(stmt->initializer!=nullptr){
+       value = evaluateExpr(stmt->initializer);
     }
-    else {
-       Evalstr value = evaluateExpr(stmt->initializer.get());
-       environment->define(stmt->name, value.value);
+
+    if (stmt->slot >= 0) {
+        environment->slots[stmt->slot] = std::move(value);
+    } else {
+        environment->define(stmt->name, value);
     }
     
 }
 
-Evalstr Evaluator::evaluateExpr(Expr* expr) {
-    if (auto binary = dynamic_cast<BinaryExpr*>(expr)) {
-        return evaluateBinary(binary);
-    } else if (auto literal = dynamic_cast<LiteralExpr*>(expr)) {
-        if (std::holds_alternative<std::string>(literal->value)) {
-
-            return {std::get<std::string>(literal->value),"string"};
-              
-        } else if (std::holds_alternative<double>(literal->value)) {
-            double num = std::get<double>(literal->value);
-            if (num == static_cast<int>(num)) {
-                return {std::to_string(static_cast<int>(num)),"double"}; // Return as integer string
-            }
-            std::ostringstream out;
-            out << std::fixed << std::setprecision(3) << num; // Format with 3 decimal places
-            std::string str = out.str();
-            str.erase(str.find_last_not_of('0') + 1, std::string::npos); // Remove trailing zeros
-            if (!str.empty() && str.back() == '.') str.pop_back(); // Remove trailing decimal
-            return {str,"double"};
-            }
-            else if(std::holds_alternative<bool>(literal->value)){
-                return {std::get<bool>(literal->value)==true ?"true":"false","bool"};
-            }
-            else if(std::holds_alternative<NilValue>(literal->value)){
-                return {"nil", "nil"};
+Value Evaluator::evaluateExpr(Expr* expr) {
+    if (profiler) [[unlikely]] {
+        return profileExpr(expr);
+    }
+    return dispatchExpr(expr);
+}
+
+Value Evaluator::profileExpr(Expr* expr) {
+    auto start = profiler->enter();
+    Value result = dispatchExpr(expr);
+    profiler->leave(start, expr->line, Profiler::key(expr->kind));
+    return result;
+}
+
+Value Evaluator::dispatchExpr(Expr* expr) {
+    switch (expr->kind) {
+        case ExprKind::BINARY: return evaluateBinary(static_cast<BinaryExpr*>(expr));
+        case ExprKind::LITERAL: return static_cast<LiteralExpr*>(expr)->value;
+        case ExprKind::UNARY: return evaluateUnary(static_cast<UnaryExpr*>(expr));
+        case ExprKind::GROUPING: return evaluateExpr(static_cast<GroupingExpr*>(expr)->expression);
+        case ExprKind::VARIABLE: return evaluateVariableExpr(static_cast<VariableExpr*>(expr));
+        case ExprKind::ASSIGN: return evaluateAssign(static_cast<AssignExpr*>(expr));
+        case ExprKind::LOGICAL: return evaluateLogical(static_cast<LogicalExpr*>(expr));
+        case ExprKind::CALL: return evaluateCall(static_cast<CallExpr*>(expr));
+    }
+    throw std::runtime_error("Unknown expression.");
+}
+
+// Truthiness of `expr` for `if` and loop conditions. Comparisons, `!`, `and`
+// and `or` produce the bool directly instead of building a Value for it
+bool Evaluator::evaluateCondition(Expr* expr) {
+    if (profiler) [[unlikely]] {
+        return isTruthy(evaluateExpr(expr));  // Keeps every node in the profile
+    }
+    switch (expr->kind) {
+        case ExprKind::BINARY: {
+            auto binary = static_cast<BinaryExpr*>(expr);
+            Value left = evaluateExpr(binary->left);
+            Value right = evaluateOperand(left, binary->right);
+            if (left.isNumber() && right.isNumber()) {
+                switch (binary->op) {
+                    case BinaryOp::EQUAL: return left.number == right.number;
+                    case BinaryOp::NOT_EQUAL: return left.number != right.number;
+                    case BinaryOp::GREATER: return left.number > right.number;
+                    case BinaryOp::GREATER_EQUAL: return left.number >= right.number;
+                    case BinaryOp::LESS: return left.number < right.number;
+                    case BinaryOp::LESS_EQUAL: return left.number <= right.number;
+                    default: break;
+                }
             }
-    } else if (auto unary = dynamic_cast<UnaryExpr*>(expr)) {
-        return evaluateUnary(unary);
-    }
-    else if (auto grouping = dynamic_cast<GroupingExpr*>(expr)) {
-        return evaluateExpr(grouping->expression.get());  
-    } 
-
-    else if (auto varExpr = dynamic_cast<VariableExpr*>(expr)) {
-        try {
-            std::string value = environment->get(varExpr->name);
-            // Determine the datatype based on the value
-            std::string datatype = "string"; // default
-            if (value == "true" || value == "false") datatype = "bool";
-            else if (value == "nil") datatype = "nil";
-            else if (isNumber(value)) datatype = "double";
-            
-            return {value, datatype};
-        } catch (const std::runtime_error& e) {
-            std::cerr << e.what() << std::endl;
-            exit(70);
+            return isTruthy(applyBinary(binary, left, right));
         }
-    }
-    else if (auto assignExpr = dynamic_cast<AssignExpr*>(expr)) {
-        Evalstr value = evaluateExpr(assignExpr->value.get());
-        try {
-            environment->assign(assignExpr->name, value.value);
-            return value;
-        } catch (const std::runtime_error& e) {
-            std::cerr << e.what() << std::endl;
-            exit(70);
+        case ExprKind::LOGICAL: {
+            auto logical = static_cast<LogicalExpr*>(expr);
+            bool left = evaluateCondition(logical->left);
+            if (left != logical->isAnd) return left;
+            return evaluateCondition(logical->right);
         }
+        case ExprKind::UNARY: {
+            auto unary = static_cast<UnaryExpr*>(expr);
+            if (unary->op == TokenType::BANG) return !evaluateCondition(unary->right);
+            break;
+        }
+        case ExprKind::GROUPING:
+            return evaluateCondition(static_cast<GroupingExpr*>(expr)->expression);
+        case ExprKind::LITERAL:
+            return isTruthy(static_cast<LiteralExpr*>(expr)->value);
+        default:
+            break;
     }
-    throw std::runtime_error("Unknown expression.");
+    return isTruthy(evaluateExpr(expr));
 }
 
-Evalstr Evaluator::evaluateBinary(BinaryExpr* expr) {
-    Evalstr LEFT = evaluateExpr(expr->left.get());
-    Evalstr RIGHT = evaluateExpr(expr->right.get());
+// Calls run on frames from the same pool as blocks: the arguments are
+// evaluated straight into the parameter slots of the callee's body frame
+Evaluator::CallFrame Evaluator::prepareCall(CallExpr* expr) {
+    Value callee = evaluateExpr(expr->callee);
+    if (!callee.isFunction()) {
+        std::cerr << "Can only call functions and classes.\n[line " << expr->line << "]\n";
+        exit(70);
+    }
 
-    std::string left= LEFT.value;
-    std::string right=RIGHT.value;
+    const Function& function = asFunction(callee);
+    FunctionStmt* declaration = function.declaration;
+    if (expr->arguments.size() != declaration->params.size()) {
+        std::cerr << "Expected " << declaration->params.size() << " arguments but got "
+                  << expr->arguments.size() << ".\n[line " << expr->line << "]\n";
+        exit(70);
+    }
 
+    Environment* frame = acquireFrame(declaration->body->slotCount, function.closure);
+    frameRoots.push_back(frame);  // Nothing else reaches it until the call starts
+    for (size_t i = 0; i < expr->arguments.size(); i++) {
+        frame->slots[i] = evaluateExpr(expr->arguments[i]);
+    }
+    frameRoots.pop_back();
+    return {declaration, frame};
+}
 
-    if(expr->op=="=="){
-        if(LEFT.datatype=="double" && RIGHT.datatype=="double"){
-            return {left==right?"true":"false","bool"};
-        }
-        else if(LEFT.datatype=="string" && RIGHT.datatype=="string"){
-            return {left==right?"true":"false","bool"};
-        }
-       else if (LEFT.datatype=="bool" && RIGHT.datatype=="bool"){
-         return {left==right?"true":"false","bool"};
-       }
-        else {
-             return {"false","bool"};
-        }
+// Tail calls loop here on the same native frame and call depth, so
+// accumulator-style recursion runs in constant stack
+Value Evaluator::evaluateCall(CallExpr* expr) {
+    CallFrame call = prepareCall(expr);
+    auto stackTop = static_cast<const char*>(__builtin_frame_address(0));
+    if (callDepth >= maxCallDepth || stackTop < stackLimit) {
+        std::cerr << "Stack overflow.\n[line " << expr->line << "]\n";
+        exit(70);
     }
 
-    if(expr->op=="!="){
-        if(LEFT.datatype=="double" && RIGHT.datatype=="double"){
-            return {left!=right?"true":"false","bool"};
-        }
-        else if(LEFT.datatype=="string" && RIGHT.datatype=="string"){
-            return {left!=right?"true":"false","bool"};
-        }
-        else if (LEFT.datatype=="bool" && RIGHT.datatype=="bool"){
-            return {left!=right?"true":"false","bool"};
-          }
-        else {
-             return {"false","bool"};
+    Value result;
+    callDepth++;
+    while (true) {
+        executeBlock(call.declaration->body, call.frame);
+        if (returning) {
+            result = std::move(returnValue);
+            returnValue = Value();
+            returning = false;
         }
+        if (!tailCall.declaration) break;
+        // The tail call's arguments are already bound, so this frame is done
+        releaseFrame(call.frame);
+        call = std::exchange(tailCall, CallFrame{});
     }
+    callDepth--;
 
+    releaseFrame(call.frame);
+    return result;
+}
+
+Value Evaluator::evaluateLogical(LogicalExpr* expr) {
+    Value left = evaluateExpr(expr->left);
+    if (isTruthy(left) != expr->isAnd) return left;  // `false and ...`, `true or ...`
+    return evaluateExpr(expr->right);
+}
 
-    if (isNumber(left) && isNumber(right)) {
-        double leftNum = std::stod(left);
-        double rightNum = std::stod(right);
-        if (expr->op == "+") return {formatNumbers(std::to_string(leftNum + rightNum)),"double"};
-        if (expr->op == "-") return {formatNumbers( std::to_string(leftNum - rightNum)),"double"};
-        if (expr->op == "*") return {formatNumbers( std::to_string(leftNum * rightNum)),"double"};
-        if (expr->op == "/") return {rightNum != 0 ? formatNumbers(std::to_string(leftNum / rightNum) ): "ERROR","double"};
-        if( expr->op ==">") return {leftNum>rightNum?"true" : "false","bool"};
-        if( expr->op == ">=") return {leftNum>= rightNum ?"true" :"false","bool"};
-        if( expr->op == "<") return {leftNum< rightNum ?"true" :"false","bool"};
-        if( expr->op == "<=") return {leftNum<= rightNum ?"true" :"false","bool"};
+Value Evaluator::evaluateVariableExpr(VariableExpr* expr) {
+    if (expr->depth >= 0) {
+        return environment->slotAt(expr->depth, expr->slot);
     }
-    if (expr->op == "+") {
-        if(LEFT.datatype!="string" || RIGHT.datatype!="string"){
-            std::cerr<<"Operands must be numbers. \n[line 1]\n";
-            exit(70);
-        }
-        return {left + right,"string"};  // Concatenation
-    }else {
-        std::cerr<<"Operands must be numbers. \n[line 1]\n";
+    try {
+        return globals->get(expr->name);
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
         exit(70);
     }
-    
-   
-    // throw std::runtime_error("Invalid binary operation.");
 }
 
-Evalstr Evaluator::evaluateUnary(UnaryExpr* expr) {
-    Evalstr RIGHT= evaluateExpr(expr->right.get());
-    std::string right = RIGHT.value;
-    size_t pos= right.find('.');
-    if(expr->op.lexeme=="-") {
-        if(RIGHT.datatype=="double"){
-          if(pos==std::string::npos){
-            return {std::to_string(-std::stoi(right)),"double"};
-        }  
-        }
-        else {
-            std::cerr << "Operand must be a number.\n[line " << expr->op.line << "]\n";
-            exit(70); // Ensures correct runtime error code
-        }
-        
+Value Evaluator::evaluateAssign(AssignExpr* expr) {
+    Value value = evaluateExpr(expr->value);
+    if (expr->depth >= 0) {
+        environment->slotAt(expr->depth, expr->slot) = value;
+        return value;
     }
+    try {
+        globals->assign(expr->name, value);
+        return value;
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        exit(70);
+    }
+}
 
-   // if (expr->op.lexeme == "-") return std::to_string(-std::stod(right));
-   
-        if (expr->op.lexeme == "!") {
-            // Convert numbers to booleans
-            if (right == "nil" || right == "false") {
-                return {"true","string"};
-            }
-            if (right == "true") {
-                return {"false","string"};
-            }
-            
-               
-                double num = std::stod(right);
-                right = (num == 0) ? "false" : "true";
-            
+Value Evaluator::evaluateBinary(BinaryExpr* expr) {
+    Value left = evaluateExpr(expr->left);
+    Value right = evaluateOperand(left, expr->right);
+    return applyBinary(expr, left, right);
+}
 
-            return {(right == "true") ? "false" : "true","double"};
+// Evaluates `expr` while `held` lives only in a native local. A string or
+// function in it is kept as a root in case `expr` calls into a collection.
+Value Evaluator::evaluateOperand(const Value& held, Expr* expr) {
+    if (!held.object) return evaluateExpr(expr);
+    temporaries.push_back(held);
+    Value result = evaluateExpr(expr);
+    temporaries.pop_back();
+    return result;
+}
+
+Value Evaluator::applyBinary(BinaryExpr* expr, const Value& left, const Value& right) {
+    if (expr->op == BinaryOp::EQUAL) return Value(valuesEqual(left, right));
+    if (expr->op == BinaryOp::NOT_EQUAL) return Value(!valuesEqual(left, right));
+
+    if (left.isNumber() && right.isNumber()) {
+        double leftNum = left.number;
+        double rightNum = right.number;
+        switch (expr->op) {
+            case BinaryOp::ADD: return Value(leftNum + rightNum);
+            case BinaryOp::SUBTRACT: return Value(leftNum - rightNum);
+            case BinaryOp::MULTIPLY: return Value(leftNum * rightNum);
+            case BinaryOp::DIVIDE: return Value(leftNum / rightNum);
+            case BinaryOp::GREATER: return Value(leftNum > rightNum);
+            case BinaryOp::GREATER_EQUAL: return Value(leftNum >= rightNum);
+            case BinaryOp::LESS: return Value(leftNum < rightNum);
+            case BinaryOp::LESS_EQUAL: return Value(leftNum <= rightNum);
+            default: break;
         }
-    
+    }
+    if (expr->op == BinaryOp::ADD && left.isString() && right.isString()) {
+        MemoryScope memory(MemoryTag::STRINGS);
+        return concatenate(heap, left, right);
+    }
 
-    throw std::runtime_error("Unsupported unary operator.");
+    std::cerr<<"Operands must be numbers. \n[line "<<expr->line<<"]\n";
+    exit(70);
 }
 
-bool Evaluator::isNumber(const std::string& str) {
-    if (str.empty()) return false;
-    
-    char* end;
-    std::strtod(str.c_str(), &end);
-    
-    return *end == '\0'; 
+Value Evaluator::evaluateUnary(UnaryExpr* expr) {
+    Value right = evaluateExpr(expr->right);
+
+    if (expr->op == TokenType::MINUS) {
+        if (!right.isNumber()) {
+            std::cerr << "Operand must be a number.\n[line " << expr->line << "]\n";
+            exit(70); // Ensures correct runtime error code
+        }
+        return Value(-right.number);
+    }
+
+    if (expr->op == TokenType::BANG) {
+        return Value(!isTruthy(right));
+    }
+
+    throw std::runtime_error("Unsupported unary operator.");
 }
@@ -6,32 +6,90 @@
 #include <string>
 #include "ast.h"
 #include "environment.h"
+#include "heap.h"
+#include "profiler.h"
+#include "value.h"
 #include <unordered_map>
-#include <iomanip>
-
-struct Evalstr {
-    std::string value;
-    std::string datatype;
-};
 
 class Evaluator {
 private:
     bool isEvaluatedMode;
-    Evalstr evaluateExpr(Expr* expr);
-    Evalstr evaluateBinary(BinaryExpr* expr);
-    Evalstr evaluateUnary(UnaryExpr* expr);
-    bool isNumber(const std::string& str);
+    Profiler* profiler = nullptr;
+    Value evaluateExpr(Expr* expr);
+    Value dispatchExpr(Expr* expr);
+    void dispatchStmt(Stmt* stmt);
+    Value profileExpr(Expr* expr);
+    void profileStmt(Stmt* stmt);
+    Value evaluateBinary(BinaryExpr* expr);
+    Value evaluateOperand(const Value& held, Expr* expr);
+    Value applyBinary(BinaryExpr* expr, const Value& left, const Value& right);
+    Value evaluateLogical(LogicalExpr* expr);
+    Value evaluateCall(CallExpr* expr);
+    bool evaluateCondition(Expr* expr);
+    Value evaluateUnary(UnaryExpr* expr);
+    Value evaluateVariableExpr(VariableExpr* expr);
+    Value evaluateAssign(AssignExpr* expr);
     void evaluatePrint(PrintStmt* stmt);
     void evaluateBlock(BlockStmt *stmt);
+    void executeBlock(BlockStmt* stmt, Environment* frame);
     void evaluateIf(IfStmt* stmt);
+    void evaluateWhile(WhileStmt* stmt);
+    void evaluateFunction(FunctionStmt* stmt);
+    void evaluateReturn(ReturnStmt* stmt);
     void evaluateExpression(ExpressionStmt * stmt);
-    std::shared_ptr<Environment> globals;
-    std::shared_ptr<Environment> environment;
+    Heap heap;
+    Environment* globals;
+    Environment* environment;
+
+    // Block frames whose block has finished and that no closure captured
+    static constexpr size_t MAX_POOLED_FRAMES = 256;
+    std::vector<Environment*> framePool;
+    Environment* acquireFrame(size_t slotCount, Environment* parent);
+    void releaseFrame(Environment* frame);
+
+    // Roots the collector can't find through `environment`: the scopes of
+    // blocks and calls further out, loop frames while the condition runs,
+    // frames still being filled with arguments, and operands held while
+    // the other side of a binary expression runs
+    std::vector<Environment*> frameRoots;
+    std::vector<Value> temporaries;
+    void collectGarbage();
+
+    // A checked callee and the frame its arguments were bound into
+    struct CallFrame {
+        FunctionStmt* declaration = nullptr;
+        Environment* frame = nullptr;
+    };
+    CallFrame prepareCall(CallExpr* expr);
+
+    // `return` sets these; blocks and loops stop early until the call takes the value.
+    // `return f(...)` leaves f's frame in tailCall for the caller to run in its place
+    bool returning = false;
+    Value returnValue;
+    CallFrame tailCall;
+    int callDepth = 0;
+    int maxCallDepth = DEFAULT_MAX_CALL_DEPTH;
+    bool createdFunction = false;
+
+    // Each Lox call nests several native frames. Calls stop with "Stack
+    // overflow." once the thread's stack gets within STACK_RESERVE of its
+    // end, whatever maxCallDepth allows; nullptr if the bounds are unknown
+    static constexpr size_t STACK_RESERVE = 256 * 1024;
+    const char* stackLimit = nullptr;
 
 public:
+    static constexpr int DEFAULT_MAX_CALL_DEPTH = 2000;
+
     Evaluator(bool isEvaluatedMode=false);
-    std::string evaluate(std::unique_ptr<Expr>& expr);
-    void evaluateStmt(const std::unique_ptr<Stmt>& stmt);
+    // Times every node executed from now on; nullptr turns profiling off
+    void setProfiler(Profiler* profiler) { this->profiler = profiler; }
+    // Calls nested deeper than this stop the program with "Stack overflow."
+    // The native stack may run out first; that is reported the same way
+    void setMaxCallDepth(int depth) { maxCallDepth = depth; }
+    void setGcConfig(const GcConfig& config) { heap.configure(config); }
+    // Function values point into the AST, which must then be kept
+    bool hasCreatedFunctions() const { return createdFunction; }
+    void evaluateStmt(Stmt* stmt);
     void evaluateVariable(VarDeclStmt* stmt);
     void evaluateProgram(const std::unique_ptr<Program>& program);
 };
@@ -0,0 +1,20 @@
+#ifndef FUNCTION_H
+#define FUNCTION_H
+
+#include "ast.h"
+#include "environment.h"
+#include "value.h"
+
+// A `fun` declaration closed over the scope it was declared in. The
+// declaration lives in the program's arena, which must outlive the function.
+struct Function : Object {
+    FunctionStmt* declaration;
+    Environment* closure;
+
+    Function(FunctionStmt* declaration, Environment* closure)
+        : Object(ObjectType::FUNCTION), declaration(declaration), closure(closure) {}
+};
+
+inline Function& asFunction(const Value& value) { return *static_cast<Function*>(value.object); }
+
+#endif // FUNCTION_H
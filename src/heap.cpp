@@ -0,0 +1,153 @@
+#include "heap.h"
+#include "closure.h"
+#include "environment.h"
+#include "function.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+GcStats totals;
+
+}  // namespace
+
+Heap::~Heap() {
+    for (Object* list : {objects, unswept}) {
+        while (list != nullptr) {
+            Object* next = list->next;
+            destroy(list);
+            list = next;
+        }
+    }
+}
+
+void Heap::configure(const GcConfig& config) {
+    this->config = config;
+    threshold = config.initialThreshold;
+}
+
+size_t Heap::sizeOf(const Object* object) {
+    switch (object->type) {
+        case ObjectType::STRING:
+            return sizeof(StringBuffer) + static_cast<const StringBuffer*>(object)->text.capacity();
+        case ObjectType::FUNCTION:
+            return sizeof(Function);
+        case ObjectType::ENVIRONMENT: {
+            auto environment = static_cast<const Environment*>(object);
+            return sizeof(Environment) + environment->slots.capacity() * sizeof(Value) +
+                   environment->values.size() * sizeof(std::pair<const Symbol, Value>);
+        }
+        case ObjectType::CLOSURE:
+            return sizeof(Closure) + static_cast<const Closure*>(object)->upvalues.capacity() * sizeof(Upvalue*);
+        case ObjectType::UPVALUE:
+            return sizeof(Upvalue);
+    }
+    return 0;
+}
+
+void Heap::destroy(Object* object) {
+    switch (object->type) {
+        case ObjectType::STRING: delete static_cast<StringBuffer*>(object); break;
+        case ObjectType::FUNCTION: delete static_cast<Function*>(object); break;
+        case ObjectType::ENVIRONMENT: delete static_cast<Environment*>(object); break;
+        case ObjectType::CLOSURE: delete static_cast<Closure*>(object); break;
+        case ObjectType::UPVALUE: delete static_cast<Upvalue*>(object); break;
+    }
+}
+
+void Heap::trace() {
+    while (!gray.empty()) {
+        Object* object = gray.back();
+        gray.pop_back();
+        switch (object->type) {
+            case ObjectType::STRING:
+                break;
+            case ObjectType::FUNCTION:
+                mark(static_cast<Function*>(object)->closure);
+                break;
+            case ObjectType::ENVIRONMENT: {
+                auto environment = static_cast<Environment*>(object);
+                mark(environment->enclosing);
+                for (const Value& value : environment->slots) mark(value);
+                for (const auto& [name, value] : environment->values) mark(value);
+                break;
+            }
+            case ObjectType::CLOSURE:
+                for (Upvalue* upvalue : static_cast<Closure*>(object)->upvalues) mark(upvalue);
+                break;
+            case ObjectType::UPVALUE:
+                mark(static_cast<Upvalue*>(object)->closed);  // An open one's value is on the VM's stack
+                break;
+        }
+    }
+}
+
+// Everything made so far is left to be swept. The heap is resized from
+// what the marking found live, which also corrects for objects that grew
+// after they were made.
+void Heap::startSweep(std::chrono::steady_clock::time_point start) {
+    unswept = objects;
+    objects = nullptr;
+    untilSweep = SWEEP_INTERVAL;
+    allocated = marked;
+    marked = 0;
+    threshold = std::max(config.initialThreshold, static_cast<size_t>(allocated * config.growthFactor));
+
+    auto pause = std::chrono::steady_clock::now() - start;
+    totals.collections++;
+    totals.totalPause += pause;
+    totals.maxPause = std::max<std::chrono::nanoseconds>(totals.maxPause, pause);
+}
+
+void Heap::sweepSlice() {
+    auto start = std::chrono::steady_clock::now();
+    sweep(SWEEP_SLICE);
+    untilSweep = SWEEP_INTERVAL;
+
+    auto pause = std::chrono::steady_clock::now() - start;
+    totals.totalPause += pause;
+    totals.maxPause = std::max<std::chrono::nanoseconds>(totals.maxPause, pause);
+}
+
+// Looks at up to `limit` unswept objects: frees those that weren't marked,
+// and clears the marks on the rest and moves them back to `objects`
+void Heap::sweep(size_t limit) {
+    uint64_t freed = 0;
+    uint64_t bytes = 0;
+    for (; unswept != nullptr && limit > 0; limit--) {
+        Object* object = unswept;
+        unswept = object->next;
+        if (object->marked) {
+            object->marked = false;
+            object->next = objects;
+            objects = object;
+        } else {
+            bytes += sizeOf(object);
+            destroy(object);
+            freed++;
+        }
+    }
+    totals.objectsFreed += freed;
+    totals.bytesFreed += bytes;
+}
+
+GcStats gcStats() {
+    GcStats stats = totals;
+    stats.peakBytes = Heap::peakAllocated;
+    return stats;
+}
+
+void reportGcStats(std::ostream& out) {
+    GcStats stats = gcStats();
+    char buffer[160];
+    auto ms = [](std::chrono::nanoseconds ns) { return ns.count() / 1e6; };
+    std::snprintf(buffer, sizeof buffer,
+                  "gc: %llu collections, %.3f ms paused (max %.3f ms)\n"
+                  "gc: freed %llu objects, %llu bytes; peak heap %llu bytes\n",
+                  static_cast<unsigned long long>(stats.collections),
+                  ms(stats.totalPause), ms(stats.maxPause),
+                  static_cast<unsigned long long>(stats.objectsFreed),
+                  static_cast<unsigned long long>(stats.bytesFreed),
+                  static_cast<unsigned long long>(stats.peakBytes));
+    out << buffer;
+}
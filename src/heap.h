@@ -0,0 +1,117 @@
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <utility>
+#include <vector>
+#include "value.h"
+
+// When a Heap collects; set with --gc-threshold and --gc-growth
+struct GcConfig {
+    size_t initialThreshold = 1 << 20;  // Bytes allocated before the first collection
+    double growthFactor = 2.0;          // Then: once the heap is this many times what survived
+};
+
+// Totals over every Heap in the process, for --gc-stats. Pauses are the
+// collections themselves and the sweep slices that follow them.
+struct GcStats {
+    uint64_t collections = 0;
+    uint64_t objectsFreed = 0;
+    uint64_t bytesFreed = 0;
+    uint64_t peakBytes = 0;
+    std::chrono::nanoseconds totalPause{0};
+    std::chrono::nanoseconds maxPause{0};
+};
+
+// Precise mark-and-sweep collector owning the runtime's strings, functions,
+// environments, and the VM's closures and upvalues. It never runs by itself:
+// the owner checks shouldCollect() at points where everything live is
+// reachable from what it marks as roots, and only then calls collect().
+//
+// Marking only visits what is live, which stays small; freeing the garbage
+// is what takes time. So collect() only marks, and the unmarked objects are
+// freed a slice at a time by the allocations that follow.
+class Heap {
+public:
+    explicit Heap(GcConfig config = {}) { configure(config); }
+    ~Heap();  // Frees whatever is still allocated
+
+    Heap(const Heap&) = delete;
+    Heap& operator=(const Heap&) = delete;
+
+    void configure(const GcConfig& config);
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        T* object = new T(std::forward<Args>(args)...);
+        object->next = objects;
+        objects = object;
+        count(sizeOf(object));
+        if (unswept != nullptr && --untilSweep == 0) [[unlikely]] sweepSlice();
+        return object;
+    }
+
+    // A string grew in place; counts towards the next collection
+    void grew(size_t bytes) { count(bytes); }
+
+    bool shouldCollect() const { return allocated > threshold; }
+
+    // `markRoots(heap)` marks everything the owner holds; the rest is freed
+    template <typename MarkRoots>
+    void collect(MarkRoots&& markRoots) {
+        auto start = std::chrono::steady_clock::now();
+        sweep(SIZE_MAX);  // Marks left from the last collection must be cleared first
+        markRoots(*this);
+        trace();
+        startSweep(start);
+    }
+
+    void mark(Object* object) {
+        if (object == nullptr || object->marked) return;
+        object->marked = true;
+        marked += sizeOf(object);
+        if (object->type != ObjectType::STRING) gray.push_back(object);  // Strings have no children
+    }
+    void mark(const Value& value) { mark(value.object); }
+
+private:
+    // Every SWEEP_INTERVAL allocations, up to SWEEP_SLICE objects are swept:
+    // several per allocation, so a sweep is done long before the next collection
+    static constexpr int SWEEP_INTERVAL = 64;
+    static constexpr size_t SWEEP_SLICE = 256;
+
+    GcConfig config;
+    Object* objects = nullptr;  // Everything made here, newest first, except...
+    Object* unswept = nullptr;  // ...what the last collection hasn't swept yet
+    int untilSweep = 0;
+    size_t allocated = 0;  // Bytes made since the last collection, plus what it found live
+    size_t marked = 0;
+    size_t threshold = 0;
+    std::vector<Object*> gray;  // Marked, children not visited yet
+
+    // Largest `allocated` of any Heap so far. Kept as it grows, so it is
+    // right even when a runtime error exits without destroying the heap.
+    static inline size_t peakAllocated = 0;
+
+    void count(size_t bytes) {
+        allocated += bytes;
+        if (allocated > peakAllocated) peakAllocated = allocated;
+    }
+
+    static size_t sizeOf(const Object* object);
+    static void destroy(Object* object);
+    void trace();
+    void startSweep(std::chrono::steady_clock::time_point start);
+    void sweepSlice();
+    void sweep(size_t limit);
+
+    friend GcStats gcStats();
+};
+
+GcStats gcStats();
+void reportGcStats(std::ostream& out);
+
+#endif // HEAP_H
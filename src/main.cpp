@@ -2,14 +2,128 @@
 #include "parser.h"
 #include "evaluator.h"
 #include "runner.h"
-#include <fstream>
+#include "source.h"
+#include "resolver.h"
+#include "optimizer.h"
+#include "compiler.h"
+#include "vm.h"
+#include "output.h"
+#include "profiler.h"
+#include "perf.h"
+#include "allocation.h"
+#include "heap.h"
+#include <charconv>
 #include <iostream>
 #include <sstream>
+#include <algorithm>
+#include <unistd.h>
 
 
 
 using namespace std;
 
+// Flags accepted after the command, before or after the filename
+struct Options {
+    std::string filename;
+    bool stream = false;  // run: execute each statement as soon as it is parsed
+    bool optimized = false;  // parse: print the tree after the optimizer ran
+    int optLevel = Optimizer::MAX_LEVEL;
+    size_t outputBuffer = OutputSink::DEFAULT_CAPACITY;  // Bytes of stdout held before a write
+    bool lineBuffered = false;  // Flush stdout at every newline (always on for terminals)
+    bool profile = false;  // run/evaluate: print per-line hot spots to stderr at the end
+    bool perfStats = false;  // Per-phase counters to stderr; perfJson picks JSON over a table
+    bool perfJson = false;
+    bool memStats = false;  // Allocations and live/peak bytes per subsystem, at exit
+    int maxCallDepth = Evaluator::DEFAULT_MAX_CALL_DEPTH;  // run/evaluate/vm: deeper calls are a runtime error
+    GcConfig gc;  // When the collector runs
+    bool gcStats = false;  // Collections, pauses and bytes freed, at exit
+};
+
+// Prints the --mem-stats table from static destruction, which also runs on
+// a runtime error's exit()
+struct MemoryReport {
+    ~MemoryReport() {
+        if (memoryTrackingEnabled()) reportMemoryStats(std::cerr);
+    }
+};
+
+// Same as MemoryReport, for --gc-stats
+struct GcReport {
+    bool enabled;
+    ~GcReport() {
+        if (enabled) reportGcStats(std::cerr);
+    }
+};
+
+static bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--stream") {
+            options.stream = true;
+        } else if (arg == "--line-buffered") {
+            options.lineBuffered = true;
+        } else if (arg.compare(0, 16, "--output-buffer=") == 0) {
+            const char* first = arg.data() + 16;
+            const char* last = arg.data() + arg.size();
+            auto [end, error] = std::from_chars(first, last, options.outputBuffer);
+            if (first == last || error != std::errc() || end != last) {
+                std::cerr << "Invalid output buffer size: " << arg.substr(16) << std::endl;
+                return false;
+            }
+        } else if (arg == "--perf-stats" || arg == "--perf-stats=text") {
+            options.perfStats = true;
+        } else if (arg == "--perf-stats=json") {
+            options.perfStats = true;
+            options.perfJson = true;
+        } else if (arg == "--mem-stats") {
+            options.memStats = true;
+        } else if (arg == "--profile") {
+            options.profile = true;
+        } else if (arg == "--optimized") {
+            options.optimized = true;
+        } else if (arg.compare(0, 12, "--opt-level=") == 0) {
+            std::string level = arg.substr(12);
+            if (level.size() != 1 || level[0] < '0' || level[0] > '0' + Optimizer::MAX_LEVEL) {
+                std::cerr << "Invalid optimization level: " << level << std::endl;
+                return false;
+            }
+            options.optLevel = level[0] - '0';
+        } else if (arg.compare(0, 17, "--max-call-depth=") == 0) {
+            const char* first = arg.data() + 17;
+            const char* last = arg.data() + arg.size();
+            auto [end, error] = std::from_chars(first, last, options.maxCallDepth);
+            if (first == last || error != std::errc() || end != last || options.maxCallDepth < 1) {
+                std::cerr << "Invalid max call depth: " << arg.substr(17) << std::endl;
+                return false;
+            }
+        } else if (arg == "--gc-stats") {
+            options.gcStats = true;
+        } else if (arg.compare(0, 15, "--gc-threshold=") == 0) {
+            const char* first = arg.data() + 15;
+            const char* last = arg.data() + arg.size();
+            auto [end, error] = std::from_chars(first, last, options.gc.initialThreshold);
+            if (first == last || error != std::errc() || end != last) {
+                std::cerr << "Invalid GC threshold: " << arg.substr(15) << std::endl;
+                return false;
+            }
+        } else if (arg.compare(0, 12, "--gc-growth=") == 0) {
+            const char* first = arg.data() + 12;
+            const char* last = arg.data() + arg.size();
+            auto [end, error] = std::from_chars(first, last, options.gc.growthFactor);
+            if (first == last || error != std::errc() || end != last || !(options.gc.growthFactor >= 1.0)) {
+                std::cerr << "Invalid GC growth factor: " << arg.substr(12) << std::endl;
+                return false;
+            }
+        } else if (arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        } else {
+            options.filename = arg;
+        }
+    }
+    return !options.filename.empty();
+}
+
 std::ostream& operator<<(std::ostream& os, const TokenType& type) {
     switch (type) {
         case TokenType::IDENTIFIER: os << "IDENTIFIER"; break;
@@ -43,91 +157,177 @@ std::ostream& operator<<(std::ostream& os, const TokenType& type) {
 }
 
 
-std::string read_file_contents(const std::string& filename);
-
 int main(int argc, char *argv[]) {
-    // Disable output buffering
-    std::cout << std::unitbuf;
+    // Diagnostics are unbuffered; program output is batched by the OutputSink below
     std::cerr << std::unitbuf;
 
     // You can use print statements as follows for debugging, they'll be visible when running tests.
     // std::cerr << "Logs from your program will appear here!" << std::endl;
 
-    if (argc < 3) {
-        std::cerr << "Usage: ./your_program tokenize <filename>" << std::endl;
+    Options options;
+    if (argc < 3 || !parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: ./your_program <tokenize|parse|evaluate|run|vm> [--stream] [--opt-level=0-2] [--optimized]\n"
+                  << "       [--output-buffer=<bytes>] [--line-buffered] [--profile]\n"
+                  << "       [--perf-stats[=text|json]] [--mem-stats] [--max-call-depth=<n>]\n"
+                  << "       [--gc-stats] [--gc-threshold=<bytes>] [--gc-growth=<factor>] <filename>" << std::endl;
         return 1;
     }
 
+    // Static so exit() after a runtime error still flushes it
+    static OutputSink output(STDOUT_FILENO, options.outputBuffer,
+                             options.lineBuffered || isatty(STDOUT_FILENO));
+    output.install(std::cout);
+
+    // Static so a runtime error's exit() still reports the phases so far
+    static PerfStats perf(options.perfStats, options.perfJson);
+    static MemoryReport memoryReport;
+    static GcReport gcReport{options.gcStats};
+    if (options.memStats) {
+        startMemoryTracking();
+    }
+
     const std::string command = argv[1];
-    vector<Token>tokens ;
-    int result ;
-    string file_contents = read_file_contents(argv[2]);
-    result= tokenize(file_contents,tokens);
+    SourceBuffer source;  // Memory-mapped when possible; must outlive the tokens
+    perf.begin("read");
+    if (!source.load(options.filename)) {
+        std::cerr << "Error reading file: " << options.filename << std::endl;
+        return 1;
+    }
+    perf.end();
+    std::string_view file_contents = source.view();
+
+    // Tokens are produced on demand by each command, so outside `tokenize`
+    // lexing is timed as part of the "tokenize+parse" phase
+    Lexer lexer(file_contents);
+
+    // Static so a runtime error's exit() still prints the report
+    static std::unique_ptr<Profiler> profiler;
+    if (options.profile) {
+        if (command != "run" && command != "evaluate") {
+            std::cerr << "--profile is only supported by run and evaluate" << std::endl;
+            return 1;
+        }
+        profiler = std::make_unique<Profiler>(file_contents);
+    }
 
 
     if (command == "tokenize") {
-        
-        for (const Token &token:tokens){
+        perf.begin("tokenize");
+        for (;;) {
+            Token token = lexer.next();
             if(token.type!=TokenType::KEYWORD){
-                cout<<token.type<<" "<<token.lexeme<<" "<<token.literal<<endl;
+                cout<<token.type<<" "<<token.lexeme(file_contents)<<" "<<tokenLiteral(token, file_contents)<<'\n';
             }
             else if (token.type == TokenType::EOF_TOKEN){
-                cout<<"EOF  null"<<endl;
+                cout<<"EOF  null\n";
             }
             else{
-                string keyword=token.lexeme;
+                string keyword(token.lexeme(file_contents));
                 transform(keyword.begin(),keyword.end(),keyword.begin(),::toupper);
-                cout<<keyword<<" "<<token.lexeme<<" "<<token.literal<<endl;
+                cout<<keyword<<" "<<token.lexeme(file_contents)<<" null\n";
             }
+            if (token.type == TokenType::EOF_TOKEN) break;
         }
+        perf.end();
     } 
 
     
   
     else if (command=="parse"){
-        Parser parser(tokens,true);
-    auto ast = parser.parseProgram();
+        Parser parser(lexer,true);
+        perf.begin("tokenize+parse");
+        auto ast = parser.parseProgram();
+        perf.end();
+        if (ast && options.optimized) {
+            Resolver resolver;
+            resolver.resolve(ast);
+            Optimizer(options.optLevel).optimize(ast);
+        }
         if (ast) {
-            std::cout << ast->toString() << std::endl;
+            std::cout << ast->toString() << '\n';
         }
     }
     else if (command =="evaluate"){
-        Parser parserforEvaluate(tokens,true);
+        Parser parserforEvaluate(lexer,true);
+        perf.begin("tokenize+parse");
         auto ast = parserforEvaluate.parseProgram();
+        perf.end();
+        perf.begin("resolve+optimize");
+        Resolver resolver;
+        resolver.resolve(ast);
+        Optimizer(options.optLevel).optimize(ast);
+        perf.end();
         Evaluator evaluator(true);
+        evaluator.setProfiler(profiler.get());
+        evaluator.setMaxCallDepth(options.maxCallDepth);
+        evaluator.setGcConfig(options.gc);
+        perf.begin("evaluate");
         evaluator.evaluateProgram(ast);
+        perf.end();
 
     }
+    else if (command == "run" && options.stream) {
+        Parser parserforRun(lexer,false);
+        Runner runner;
+        perf.begin("tokenize+parse+evaluate");  // Interleaved, one statement at a time
+        runner.runStreaming(parserforRun, options.optLevel, profiler.get(), options.maxCallDepth, options.gc);  // Statements run before the rest of the file is lexed
+        perf.end();
+    }
     else if (command == "run") {
-        Parser parserforRun(tokens,false);
+        Parser parserforRun(lexer,false);
+        perf.begin("tokenize+parse");
         auto ast = parserforRun.parseProgram();  // AST should be a list of statements
+        perf.end();
 
         if (!ast) {
             std::cerr << "Parsing failed!" << std::endl;
             return 1;
         }
 
+        perf.begin("resolve+optimize");
+        Resolver resolver;
+        resolver.resolve(ast);  // Lexical addressing for locals
+        Optimizer(options.optLevel).optimize(ast);  // Needs the Resolver's addressing
+        perf.end();
+
         Runner runner;
-        runner.run(ast);  // Executes statements, printing output when needed
+        perf.begin("evaluate");
+        runner.run(ast, profiler.get(), options.maxCallDepth, options.gc);  // Executes statements, printing output when needed
+        perf.end();
+    }
+    else if (command == "vm") {
+        Parser parserforVm(lexer,false);
+        perf.begin("tokenize+parse");
+        auto ast = parserforVm.parseProgram();
+        perf.end();
+
+        if (!ast) {
+            std::cerr << "Parsing failed!" << std::endl;
+            return 1;
+        }
+
+        perf.begin("compile");
+        Resolver resolver;  // The compiler ignores slots, but the optimizer needs them
+        resolver.resolve(ast);
+        Optimizer(options.optLevel).optimize(ast);
+
+        Compiler compiler;
+        auto chunk = compiler.compile(ast);
+        perf.end();
+        VM vm(options.gc);
+        vm.setMaxCallDepth(options.maxCallDepth);
+        perf.begin("execute");
+        vm.run(*chunk);  // Executes the compiled bytecode, output matches `run`
+        perf.end();
     }
     else {
         std::cerr << "Unknown command: " << command << std::endl;
         return 1;
     }
 
-    return result;
-}
-
-std::string read_file_contents(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error reading file: " << filename << std::endl;
-        std::exit(1);
+    if (profiler) {
+        profiler->report(std::cerr);
     }
-
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    file.close();
-
-    return buffer.str();
+    perf.report(std::cerr);
+    return lexer.hadError() ? 65 : 0;
 }
@@ -0,0 +1,380 @@
+#include "optimizer.h"
+#include "allocation.h"
+
+// Mirrors Evaluator::evaluateBinary; returns false where it would report an error
+static bool foldBinary(BinaryOp op, const Value& left, const Value& right, Value& result) {
+    if (op == BinaryOp::EQUAL) { result = Value(valuesEqual(left, right)); return true; }
+    if (op == BinaryOp::NOT_EQUAL) { result = Value(!valuesEqual(left, right)); return true; }
+
+    if (left.isNumber() && right.isNumber()) {
+        double leftNum = left.number;
+        double rightNum = right.number;
+        switch (op) {
+            case BinaryOp::ADD: result = Value(leftNum + rightNum); return true;
+            case BinaryOp::SUBTRACT: result = Value(leftNum - rightNum); return true;
+            case BinaryOp::MULTIPLY: result = Value(leftNum * rightNum); return true;
+            case BinaryOp::DIVIDE: result = Value(leftNum / rightNum); return true;
+            case BinaryOp::GREATER: result = Value(leftNum > rightNum); return true;
+            case BinaryOp::GREATER_EQUAL: result = Value(leftNum >= rightNum); return true;
+            case BinaryOp::LESS: result = Value(leftNum < rightNum); return true;
+            case BinaryOp::LESS_EQUAL: result = Value(leftNum <= rightNum); return true;
+            default: break;
+        }
+    }
+    if (op == BinaryOp::ADD && left.isString() && right.isString()) {
+        // Interned like a literal, so the constant needs no Heap and outlives the AST
+        std::string text;
+        text.reserve(left.length + right.length);
+        text.append(left.asString());
+        text.append(right.asString());
+        result = Value(symbolString(intern(text)));
+        return true;
+    }
+    return false;
+}
+
+static bool foldUnary(TokenType op, const Value& right, Value& result) {
+    if (op == TokenType::MINUS) {
+        if (!right.isNumber()) return false;
+        result = Value(-right.number);
+        return true;
+    }
+    if (op == TokenType::BANG) {
+        result = Value(!isTruthy(right));
+        return true;
+    }
+    return false;
+}
+
+static const Value* literalValue(Expr* expr) {
+    return expr->kind == ExprKind::LITERAL ? &static_cast<LiteralExpr*>(expr)->value : nullptr;
+}
+
+void Optimizer::optimize(const std::unique_ptr<Program>& program) {
+    if (level <= 0) return;
+    MemoryScope memory(MemoryTag::AST);
+    arena = &program->arena;
+    propagate = level >= 2;
+
+    if (propagate) {
+        for (Stmt* stmt : program->statements) {
+            collectStmt(stmt);
+        }
+    }
+
+    // Dead statements are dropped from the list instead of left as empty nodes
+    size_t kept = 0;
+    for (Stmt* stmt : program->statements) {
+        if (Stmt* optimized = optimizeStmt(stmt, true)) {
+            program->statements[kept++] = optimized;
+        }
+    }
+    program->statements.resize(kept);
+
+    locals.clear();
+    globals.clear();
+    arena = nullptr;
+}
+
+Stmt* Optimizer::optimizeTopLevel(Stmt* stmt, Arena& programArena) {
+    if (level <= 0) return stmt;
+    MemoryScope memory(MemoryTag::AST);
+    arena = &programArena;
+    propagate = false;
+    Stmt* optimized = optimizeStmt(stmt, true);
+    arena = nullptr;
+    return optimized;
+}
+
+Optimizer::Binding* Optimizer::binding(Symbol name, int depth, int slot) {
+    if (depth < 0) {
+        return &globals[name];
+    }
+    BlockStmt* block = scopes[scopes.size() - 1 - depth];
+    std::vector<Binding>& slots = locals[block];
+    if (slots.size() < static_cast<size_t>(block->slotCount)) {
+        slots.resize(block->slotCount);
+    }
+    return &slots[slot];
+}
+
+// First pass for propagation: counts declarations and spots assignments
+void Optimizer::collectStmt(Stmt* stmt) {
+    switch (stmt->kind) {
+        case StmtKind::PRINT:
+            collectExpr(static_cast<PrintStmt*>(stmt)->expression);
+            break;
+        case StmtKind::EXPRESSION:
+            collectExpr(static_cast<ExpressionStmt*>(stmt)->expression);
+            break;
+        case StmtKind::VAR_DECL: {
+            auto varStmt = static_cast<VarDeclStmt*>(stmt);
+            if (varStmt->initializer) {
+                collectExpr(varStmt->initializer);
+            }
+            binding(varStmt->name, varStmt->slot >= 0 ? 0 : -1, varStmt->slot)->declarations++;
+            break;
+        }
+        case StmtKind::ASSIGN: {
+            auto assignStmt = static_cast<AssignStmt*>(stmt);
+            collectExpr(assignStmt->value);
+            globals[assignStmt->name].assigned = true;
+            break;
+        }
+        case StmtKind::BLOCK: {
+            auto block = static_cast<BlockStmt*>(stmt);
+            scopes.push_back(block);
+            for (Stmt* statement : block->statements) {
+                collectStmt(statement);
+            }
+            scopes.pop_back();
+            break;
+        }
+        case StmtKind::IF: {
+            auto ifStmt = static_cast<IfStmt*>(stmt);
+            collectExpr(ifStmt->condition);
+            collectStmt(ifStmt->thenBranch);
+            if (ifStmt->elseBranch) {
+                collectStmt(ifStmt->elseBranch);
+            }
+            break;
+        }
+        case StmtKind::FUNCTION: {
+            // Bound to a function, never to a constant
+            auto function = static_cast<FunctionStmt*>(stmt);
+            Binding* var = binding(function->name, function->slot >= 0 ? 0 : -1, function->slot);
+            var->declarations++;
+            var->assigned = true;
+            collectStmt(function->body);  // Mirrors the Resolver: parameters live in the body's scope
+            break;
+        }
+        case StmtKind::RETURN: {
+            auto returnStmt = static_cast<ReturnStmt*>(stmt);
+            if (returnStmt->value) {
+                collectExpr(returnStmt->value);
+            }
+            break;
+        }
+        case StmtKind::WHILE: {
+            auto whileStmt = static_cast<WhileStmt*>(stmt);
+            collectExpr(whileStmt->condition);
+            collectStmt(whileStmt->body);
+            if (whileStmt->increment) {
+                collectExpr(whileStmt->increment);
+            }
+            break;
+        }
+    }
+}
+
+void Optimizer::collectExpr(Expr* expr) {
+    switch (expr->kind) {
+        case ExprKind::BINARY: {
+            auto binary = static_cast<BinaryExpr*>(expr);
+            collectExpr(binary->left);
+            collectExpr(binary->right);
+            break;
+        }
+        case ExprKind::LOGICAL: {
+            auto logical = static_cast<LogicalExpr*>(expr);
+            collectExpr(logical->left);
+            collectExpr(logical->right);
+            break;
+        }
+        case ExprKind::CALL: {
+            auto call = static_cast<CallExpr*>(expr);
+            collectExpr(call->callee);
+            for (Expr* argument : call->arguments) {
+                collectExpr(argument);
+            }
+            break;
+        }
+        case ExprKind::UNARY:
+            collectExpr(static_cast<UnaryExpr*>(expr)->right);
+            break;
+        case ExprKind::GROUPING:
+            collectExpr(static_cast<GroupingExpr*>(expr)->expression);
+            break;
+        case ExprKind::ASSIGN: {
+            auto assignExpr = static_cast<AssignExpr*>(expr);
+            collectExpr(assignExpr->value);
+            binding(assignExpr->name, assignExpr->depth, assignExpr->slot)->assigned = true;
+            break;
+        }
+        case ExprKind::LITERAL:
+        case ExprKind::VARIABLE:
+            break;
+    }
+}
+
+// Returns the statement to keep in place of `stmt`, or nullptr if it can go
+Stmt* Optimizer::optimizeStmt(Stmt* stmt, bool topLevel) {
+    switch (stmt->kind) {
+        case StmtKind::PRINT: {
+            auto printStmt = static_cast<PrintStmt*>(stmt);
+            printStmt->expression = optimizeExpr(printStmt->expression);
+            return stmt;
+        }
+        case StmtKind::EXPRESSION: {
+            auto exprStmt = static_cast<ExpressionStmt*>(stmt);
+            exprStmt->expression = optimizeExpr(exprStmt->expression);
+            return stmt;
+        }
+        case StmtKind::VAR_DECL: {
+            auto varStmt = static_cast<VarDeclStmt*>(stmt);
+            if (varStmt->initializer) {
+                varStmt->initializer = optimizeExpr(varStmt->initializer);
+            }
+            // A global is only safe to substitute after its top-level declaration:
+            // a conditional one may never run, and earlier reads must still fail
+            if (propagate && (varStmt->slot >= 0 || topLevel)) {
+                Binding* var = binding(varStmt->name, varStmt->slot >= 0 ? 0 : -1, varStmt->slot);
+                const Value* value = varStmt->initializer ? literalValue(varStmt->initializer) : nullptr;
+                if (var->declarations == 1 && !var->assigned && (value || !varStmt->initializer)) {
+                    var->known = true;
+                    var->constant = value ? *value : Value();
+                }
+            }
+            return stmt;
+        }
+        case StmtKind::ASSIGN: {
+            auto assignStmt = static_cast<AssignStmt*>(stmt);
+            assignStmt->value = optimizeExpr(assignStmt->value);
+            return stmt;
+        }
+        case StmtKind::BLOCK: {
+            // Emptied blocks are kept: the Resolver counted them in every depth
+            auto block = static_cast<BlockStmt*>(stmt);
+            scopes.push_back(block);
+            size_t kept = 0;
+            for (Stmt* statement : block->statements) {
+                if (Stmt* optimized = optimizeStmt(statement, false)) {
+                    block->statements[kept++] = optimized;
+                }
+            }
+            block->statements = block->statements.first(kept);
+            scopes.pop_back();
+            return stmt;
+        }
+        case StmtKind::IF: {
+            auto ifStmt = static_cast<IfStmt*>(stmt);
+            ifStmt->condition = optimizeExpr(ifStmt->condition);
+            // The parser rejects declarations as branches, so a surviving
+            // branch can replace the `if` without changing any scope
+            if (const Value* condition = literalValue(ifStmt->condition)) {
+                if (isTruthy(*condition)) {
+                    return optimizeStmt(ifStmt->thenBranch, false);
+                }
+                return ifStmt->elseBranch ? optimizeStmt(ifStmt->elseBranch, false) : nullptr;
+            }
+            ifStmt->thenBranch = optimizeBranch(ifStmt->thenBranch);
+            if (ifStmt->elseBranch) {
+                ifStmt->elseBranch = optimizeBranch(ifStmt->elseBranch);
+            }
+            return stmt;
+        }
+        case StmtKind::FUNCTION:
+            optimizeStmt(static_cast<FunctionStmt*>(stmt)->body, false);
+            return stmt;
+        case StmtKind::RETURN: {
+            auto returnStmt = static_cast<ReturnStmt*>(stmt);
+            if (returnStmt->value) {
+                returnStmt->value = optimizeExpr(returnStmt->value);
+            }
+            return stmt;
+        }
+        case StmtKind::WHILE: {
+            auto whileStmt = static_cast<WhileStmt*>(stmt);
+            whileStmt->condition = optimizeExpr(whileStmt->condition);
+            const Value* condition = literalValue(whileStmt->condition);
+            if (condition && !isTruthy(*condition)) {
+                return nullptr;  // The body never runs
+            }
+            whileStmt->body = optimizeBranch(whileStmt->body);
+            if (whileStmt->increment) {
+                whileStmt->increment = optimizeExpr(whileStmt->increment);
+            }
+            return stmt;
+        }
+    }
+    return stmt;
+}
+
+Expr* Optimizer::folded(const Value& value, int line) {
+    Expr* literal = arena->make<LiteralExpr>(value);
+    literal->line = line;
+    return literal;
+}
+
+Stmt* Optimizer::optimizeBranch(Stmt* branch) {
+    Stmt* optimized = optimizeStmt(branch, false);
+    if (optimized) return optimized;
+    Stmt* empty = arena->make<BlockStmt>(std::span<Stmt*>());
+    empty->line = branch->line;
+    return empty;
+}
+
+Expr* Optimizer::optimizeExpr(Expr* expr) {
+    switch (expr->kind) {
+        case ExprKind::LITERAL:
+            return expr;
+        case ExprKind::GROUPING: {
+            auto grouping = static_cast<GroupingExpr*>(expr);
+            grouping->expression = optimizeExpr(grouping->expression);
+            return literalValue(grouping->expression) ? grouping->expression : expr;
+        }
+        case ExprKind::UNARY: {
+            auto unary = static_cast<UnaryExpr*>(expr);
+            unary->right = optimizeExpr(unary->right);
+            Value result;
+            if (const Value* right = literalValue(unary->right)) {
+                if (foldUnary(unary->op, *right, result)) {
+                    return folded(result, expr->line);
+                }
+            }
+            return expr;
+        }
+        case ExprKind::BINARY: {
+            auto binary = static_cast<BinaryExpr*>(expr);
+            binary->left = optimizeExpr(binary->left);
+            binary->right = optimizeExpr(binary->right);
+            const Value* left = literalValue(binary->left);
+            const Value* right = literalValue(binary->right);
+            Value result;
+            if (left && right && foldBinary(binary->op, *left, *right, result)) {
+                return folded(result, expr->line);
+            }
+            return expr;
+        }
+        case ExprKind::LOGICAL: {
+            // A constant left operand decides which operand is the result
+            auto logical = static_cast<LogicalExpr*>(expr);
+            logical->left = optimizeExpr(logical->left);
+            logical->right = optimizeExpr(logical->right);
+            if (const Value* left = literalValue(logical->left)) {
+                return isTruthy(*left) == logical->isAnd ? logical->right : logical->left;
+            }
+            return expr;
+        }
+        case ExprKind::CALL: {
+            auto call = static_cast<CallExpr*>(expr);
+            call->callee = optimizeExpr(call->callee);
+            for (Expr*& argument : call->arguments) {
+                argument = optimizeExpr(argument);
+            }
+            return expr;
+        }
+        case ExprKind::VARIABLE: {
+            if (!propagate) return expr;
+            auto variable = static_cast<VariableExpr*>(expr);
+            Binding* var = binding(variable->name, variable->depth, variable->slot);
+            return var->known ? folded(var->constant, expr->line) : expr;
+        }
+        case ExprKind::ASSIGN: {
+            auto assign = static_cast<AssignExpr*>(expr);
+            assign->value = optimizeExpr(assign->value);
+            return expr;
+        }
+    }
+    return expr;
+}
@@ -0,0 +1,52 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+
+// AST-to-AST pass run after the Resolver. Rewrites the program in place:
+//   level 1: folds constant unary/binary/grouping subtrees into literals and
+//            drops `if` branches whose condition is a constant
+//   level 2: also replaces reads of variables that are declared once with a
+//            constant initializer and never assigned by that constant
+// Anything that would raise a runtime error is left alone so the error still
+// happens, with the same message and line, when the program runs.
+class Optimizer {
+public:
+    static constexpr int MAX_LEVEL = 2;
+
+    explicit Optimizer(int level = MAX_LEVEL) : level(level) {}
+
+    void optimize(const std::unique_ptr<Program>& program);
+    // Streams can't see later assignments, so only level 1 applies here.
+    // Returns nullptr when the whole statement is dead.
+    Stmt* optimizeTopLevel(Stmt* stmt, Arena& programArena);
+
+private:
+    struct Binding {
+        int declarations = 0;
+        bool assigned = false;
+        bool known = false;  // Set once the declaration is reached with a constant
+        Value constant;
+    };
+
+    int level;
+    bool propagate = false;
+    Arena* arena = nullptr;
+    std::vector<BlockStmt*> scopes;  // Mirrors the Resolver's scope chain
+    std::unordered_map<BlockStmt*, std::vector<Binding>> locals;
+    std::unordered_map<Symbol, Binding> globals;
+
+    Binding* binding(Symbol name, int depth, int slot);
+    void collectStmt(Stmt* stmt);
+    void collectExpr(Expr* expr);
+    Stmt* optimizeStmt(Stmt* stmt, bool topLevel);
+    Stmt* optimizeBranch(Stmt* branch);
+    Expr* optimizeExpr(Expr* expr);
+    Expr* folded(const Value& value, int line);
+};
+
+#endif // OPTIMIZER_H
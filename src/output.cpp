@@ -0,0 +1,82 @@
+#include "output.h"
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+OutputSink::OutputSink(int fd, size_t capacity, bool lineBuffered)
+    : fd(fd), buffer(capacity), lineBuffered(lineBuffered) {
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+OutputSink::~OutputSink() {
+    flush();
+    if (installed != nullptr) {
+        installed->rdbuf(previous);
+    }
+}
+
+void OutputSink::install(std::ostream& stream) {
+    stream.flush();
+    previous = stream.rdbuf(this);
+    installed = &stream;
+}
+
+bool OutputSink::flush() {
+    size_t pending = static_cast<size_t>(pptr() - pbase());
+    setp(buffer.data(), buffer.data() + buffer.size());
+    return pending == 0 || writeAll(buffer.data(), pending);
+}
+
+OutputSink::int_type OutputSink::overflow(int_type ch) {
+    if (!flush()) return traits_type::eof();
+    if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+
+    char c = traits_type::to_char_type(ch);
+    if (buffer.empty() || (lineBuffered && c == '\n')) {
+        return writeAll(&c, 1) ? ch : traits_type::eof();
+    }
+    *pptr() = c;
+    pbump(1);
+    return ch;
+}
+
+std::streamsize OutputSink::xsputn(const char* data, std::streamsize count) {
+    size_t size = static_cast<size_t>(count);
+    size_t room = static_cast<size_t>(epptr() - pptr());
+    if (size <= room) {
+        std::memcpy(pptr(), data, size);
+        pbump(static_cast<int>(size));
+    } else {
+        // Too big for what's left: send the buffered part, then this one directly
+        // unless it fits in an empty buffer
+        if (!flush()) return 0;
+        if (size < buffer.size()) {
+            std::memcpy(pptr(), data, size);
+            pbump(static_cast<int>(size));
+        } else if (!writeAll(data, size)) {
+            return 0;
+        }
+    }
+
+    if (lineBuffered && std::memchr(data, '\n', size) != nullptr && !flush()) {
+        return 0;
+    }
+    return count;
+}
+
+int OutputSink::sync() {
+    return flush() ? 0 : -1;
+}
+
+bool OutputSink::writeAll(const char* data, size_t count) {
+    while (count > 0) {
+        ssize_t written = write(fd, data, count);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        count -= static_cast<size_t>(written);
+    }
+    return true;
+}
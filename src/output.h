@@ -0,0 +1,46 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+// Buffered program output. Installed as std::cout's stream buffer, so every
+// `std::cout <<` in the interpreter is batched into large write(2) calls
+// instead of one syscall per line. std::cerr stays tied to std::cout, which
+// flushes pending output before any diagnostic, so stdout and stderr keep
+// their relative order. The sink flushes again when it is destroyed; keep it
+// in static storage so that also happens on exit().
+class OutputSink : public std::streambuf {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+
+    // `lineBuffered` flushes after every newline, for interactive use.
+    // A capacity of 0 writes everything through immediately.
+    OutputSink(int fd, size_t capacity, bool lineBuffered);
+    ~OutputSink() override;
+
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+
+    // Routes `stream` through this sink until the sink is destroyed
+    void install(std::ostream& stream);
+    bool flush();
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* data, std::streamsize count) override;
+    int sync() override;
+
+private:
+    int fd;
+    std::vector<char> buffer;
+    bool lineBuffered;
+    std::ostream* installed = nullptr;
+    std::streambuf* previous = nullptr;
+
+    bool writeAll(const char* data, size_t count);
+};
+
+#endif // OUTPUT_H
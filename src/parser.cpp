@@ -1,24 +1,42 @@
 #include "parser.h"
+#include "allocation.h"
+#include <array>
 #include <iostream>
 
-Parser::Parser(const std::vector<Token>& tokens, bool isEvaluateMode)
-    : tokens(tokens), isEvaluateMode(isEvaluateMode) {}
+static std::unique_ptr<Program> newProgram() {
+    MemoryScope memory(MemoryTag::AST);
+    return std::make_unique<Program>();
+}
+
+Parser::Parser(Lexer& lexer, bool isEvaluateMode)
+    : lexer(lexer), source(lexer.text()), isEvaluateMode(isEvaluateMode), program(newProgram()) {}
 
+// True once the EOF token itself has been consumed
 bool Parser::isAtEnd() {
-    return current >= tokens.size();
+    return consumedEof;
 }
 bool Parser::check(TokenType type)  {
     return !isAtEnd() && peek().type == type;
 }
 
-Token Parser::peek() {
-    if (isAtEnd()) return tokens.back();
-    return tokens[current];
+bool Parser::checkKeyword(Keyword keyword) {
+    return check(TokenType::KEYWORD) && peek().symbol == symbolOf(keyword);
 }
 
-Token Parser::advance() {
-    if (!isAtEnd()) current++;
-    return tokens[current - 1];
+const Token& Parser::peek() {
+    if (isAtEnd()) return previous();
+    if (filled == current) {
+        window[filled++ % LOOKAHEAD] = lexer.next();
+    }
+    return window[current % LOOKAHEAD];
+}
+
+const Token& Parser::advance() {
+    if (!isAtEnd()) {
+        if (peek().type == TokenType::EOF_TOKEN) consumedEof = true;
+        current++;
+    }
+    return previous();
 }
 
 bool Parser::match(TokenType type) {
@@ -31,41 +49,52 @@ bool Parser::match(TokenType type) {
 }
 
 void Parser::error(const Token& token, const std::string& message) {
-    std::cerr << "[line " << token.line << "] Error at '" << token.lexeme << "': " << message << std::endl;
+    std::cerr << "[line " << token.line << "] Error at '" << text(token) << "': " << message << std::endl;
     exit(65);
 }
 
 // Consume a token of expected type or throw an error
-Token Parser::consume(TokenType type, const std::string& message) {
+const Token& Parser::consume(TokenType type, const std::string& message) {
     if (peek().type == type) return advance();
     error(peek(), message);
-    return Token{type, "","", -1};  // Dummy return to satisfy compiler
+    return previous();  // Not reached: error() exits
 }
 
 // Parse the whole program, collecting all statements
 std::unique_ptr<Program> Parser::parseProgram() {
-    auto program = std::make_unique<Program>();
+    MemoryScope memory(MemoryTag::AST);
+    while (Stmt* stmt = parseNext()) {  // Keep parsing until EOF
+        program->statements.push_back(stmt);
+    }
 
-    while (current < tokens.size() - 1) {  // Keep parsing until EOF
-        auto stmt = parseStatement();
-        if (stmt) {
-            program->statements.push_back(std::move(stmt));
-        }
+    return std::move(program);
+}
+
+Stmt* Parser::parseNext() {
+    MemoryScope memory(MemoryTag::AST);
+    while (peek().type != TokenType::EOF_TOKEN) {
+        if (Stmt* stmt = parseStatement()) return stmt;
     }
+    return nullptr;
+}
 
-    return program;
+Stmt* Parser::parseStatement() {
+    if (isAtEnd()) return nullptr;
+    int line = peek().line;
+    Stmt* stmt = parseStatementBody();
+    if (stmt) stmt->line = line;
+    return stmt;
 }
 
 // Parse a statement (handling var declarations, assignments, print, and expressions)
-std::unique_ptr<Stmt> Parser::parseStatement() {
-    if (current >= tokens.size()) return nullptr;
+Stmt* Parser::parseStatementBody() {
 
     // Handle variable declaration (var x = 10;)
-    if (peek().type == TokenType::KEYWORD && peek().lexeme == "var") {
+    if (checkKeyword(Keyword::VAR)) {
         return parseVarDeclaration();
     }
 
-    if (peek().type == TokenType::KEYWORD && peek().lexeme == "print") {
+    if (checkKeyword(Keyword::PRINT)) {
         match(TokenType::KEYWORD);
         return parsePrintStatement();
     }
@@ -73,10 +102,26 @@ std::unique_ptr<Stmt> Parser::parseStatement() {
     if (peek().type==TokenType::LEFT_BRACE) {
         return parseBlock();  // Call parseBlock() when encountering '{'
     }
-    if(peek().type==TokenType::KEYWORD && peek().lexeme=="if"){
+    if (checkKeyword(Keyword::IF)) {
         match(TokenType::KEYWORD);
         return parseIfStmt();
     }
+    if (checkKeyword(Keyword::WHILE)) {
+        match(TokenType::KEYWORD);
+        return parseWhileStmt();
+    }
+    if (checkKeyword(Keyword::FOR)) {
+        match(TokenType::KEYWORD);
+        return parseForStmt();
+    }
+    if (checkKeyword(Keyword::FUN)) {
+        match(TokenType::KEYWORD);
+        return parseFunction();
+    }
+    if (checkKeyword(Keyword::RETURN)) {
+        match(TokenType::KEYWORD);
+        return parseReturnStmt();
+    }
 
     auto expr = parseExpression();
 
@@ -84,54 +129,141 @@ std::unique_ptr<Stmt> Parser::parseStatement() {
     if (match(TokenType::EQUAL)) {
         auto value = parseExpression();
         if (!match(TokenType::SEMICOLON)) {
-            error(tokens[current - 1], "Expected ';' after assignment.");
+            error(previous(), "Expected ';' after assignment.");
         }
-        return std::make_unique<AssignStmt>(dynamic_cast<VariableExpr*>(expr.get())->name, std::move(value));
+        if (expr->kind != ExprKind::VARIABLE) {
+            error(previous(), "Invalid assignment target.");
+        }
+        return make<AssignStmt>(static_cast<VariableExpr*>(expr)->name, value);
     }
 
     if (!isEvaluateMode && !match(TokenType::SEMICOLON)) {
-        error(tokens[current - 1], "Expected ';' after expression.");
+        error(previous(), "Expected ';' after expression.");
     }
 
-    return std::make_unique<ExpressionStmt>(std::move(expr));
+    return make<ExpressionStmt>(expr);
 }
 
 // Parse a `print` statement
-std::unique_ptr<Stmt> Parser::parsePrintStatement() {
+Stmt* Parser::parsePrintStatement() {
     auto expr = parseExpression();
     if (!match(TokenType::SEMICOLON)) {
         error(peek(), "Expected ';' after print statement.");
     }
-    return std::make_unique<PrintStmt>(std::move(expr));
+    return make<PrintStmt>(expr);
 }
 
-std::unique_ptr<Stmt> Parser::parseIfStmt() {
+// If-branches and loop bodies are statements, not declarations: a variable
+// or function there would exist only on some paths, so Lox rejects it
+Stmt* Parser::parseBranch() {
+    if (checkKeyword(Keyword::VAR) || checkKeyword(Keyword::FUN)) {
+        error(peek(), "Expect expression.");
+    }
+    return parseStatement();
+}
+
+Stmt* Parser::parseIfStmt() {
     consume(TokenType::LEFT_PAREN, "Expect '(' after 'if'.");
     auto condition = parseExpression();
     consume(TokenType::RIGHT_PAREN, "Expect ')' after if condition.");
 
-    auto thenBranch = parseStatement();
-    
-    std::unique_ptr<Stmt> elseBranch = nullptr;
-    if (peek().type==TokenType::KEYWORD && peek().lexeme=="else") {
+    auto thenBranch = parseBranch();
+
+    Stmt* elseBranch = nullptr;
+    if (checkKeyword(Keyword::ELSE)) {
         match(TokenType::KEYWORD);
-        elseBranch = parseStatement();
+        elseBranch = parseBranch();
+    }
+
+    return make<IfStmt>(condition, thenBranch, elseBranch);
+}
+
+Stmt* Parser::parseWhileStmt() {
+    consume(TokenType::LEFT_PAREN, "Expect '(' after 'while'.");
+    auto condition = parseExpression();
+    consume(TokenType::RIGHT_PAREN, "Expect ')' after condition.");
+
+    auto body = parseBranch();
+    return make<WhileStmt>(condition, body);
+}
+
+// `for (init; condition; increment) body` becomes
+// `{ init; while (condition) body, then increment }`
+Stmt* Parser::parseForStmt() {
+    int line = previous().line;
+    consume(TokenType::LEFT_PAREN, "Expect '(' after 'for'.");
+
+    Stmt* initializer = nullptr;
+    if (match(TokenType::SEMICOLON)) {
+        // No initializer
+    } else if (checkKeyword(Keyword::VAR)) {
+        initializer = parseVarDeclaration();
+    } else {
+        initializer = make<ExpressionStmt>(parseExpression());
+        consume(TokenType::SEMICOLON, "Expect ';' after loop initializer.");
+    }
+    if (initializer) initializer->line = line;
+
+    Expr* condition = nullptr;
+    if (!check(TokenType::SEMICOLON)) {
+        condition = parseExpression();
+    }
+    consume(TokenType::SEMICOLON, "Expect ';' after loop condition.");
+    if (!condition) condition = make<LiteralExpr>(true);
+
+    Expr* increment = nullptr;
+    if (!check(TokenType::RIGHT_PAREN)) {
+        increment = parseExpression();
     }
+    consume(TokenType::RIGHT_PAREN, "Expect ')' after for clauses.");
 
-    return std::make_unique<IfStmt>(
-        std::move(condition),
-        std::move(thenBranch),
-        std::move(elseBranch)
-    );
+    auto body = parseBranch();
+    Stmt* loop = make<WhileStmt>(condition, body, increment);
+    loop->line = line;
+    if (!initializer) return loop;
+
+    Stmt* statements[] = {initializer, loop};
+    return make<BlockStmt>(program->arena.copyArray(statements, 2));
 }
 
+// Parse a function declaration (`fun add(a, b) { ... }`)
+Stmt* Parser::parseFunction() {
+    Symbol name = consume(TokenType::IDENTIFIER, "Expect function name.").symbol;
+    consume(TokenType::LEFT_PAREN, "Expect '(' after function name.");
+
+    std::vector<Symbol> params;
+    if (!check(TokenType::RIGHT_PAREN)) {
+        do {
+            if (params.size() >= MAX_ARGUMENTS) {
+                error(peek(), "Can't have more than 255 parameters.");
+            }
+            params.push_back(consume(TokenType::IDENTIFIER, "Expect parameter name.").symbol);
+        } while (match(TokenType::COMMA));
+    }
+    consume(TokenType::RIGHT_PAREN, "Expect ')' after parameters.");
+
+    if (!check(TokenType::LEFT_BRACE)) {
+        error(peek(), "Expect '{' before function body.");
+    }
+    auto body = static_cast<BlockStmt*>(parseBlock());
+    return make<FunctionStmt>(name, program->arena.copyArray(params.data(), params.size()), body);
+}
+
+Stmt* Parser::parseReturnStmt() {
+    Expr* value = nullptr;
+    if (!check(TokenType::SEMICOLON)) {
+        value = parseExpression();
+    }
+    consume(TokenType::SEMICOLON, "Expect ';' after return value.");
+    return make<ReturnStmt>(value);
+}
 
 // Parse a variable declaration (`var x = 10;`)
-std::unique_ptr<Stmt> Parser::parseVarDeclaration() {
+Stmt* Parser::parseVarDeclaration() {
     match(TokenType::KEYWORD);  // Consume 'var'
-    Token name = consume(TokenType::IDENTIFIER, "Expect variable name.");
+    Symbol name = consume(TokenType::IDENTIFIER, "Expect variable name.").symbol;
 
-    std::unique_ptr<Expr> initializer = nullptr;
+    Expr* initializer = nullptr;
     if (match(TokenType::EQUAL)) {
         initializer = parseExpression();  // Parse assigned value
     }
@@ -140,40 +272,44 @@ std::unique_ptr<Stmt> Parser::parseVarDeclaration() {
         error(peek(), "Expected ';' after variable declaration.");
     }
 
-    return std::make_unique<VarDeclStmt>(name.lexeme, std::move(initializer));
+    return make<VarDeclStmt>(name, initializer);
 }
 
-std::unique_ptr<Stmt> Parser::parseBlock() {
-    std::vector<std::unique_ptr<Stmt>> statements;
+Stmt* Parser::parseBlock() {
+    size_t base = blockStack.size();
 
     // Consume the '{' (assuming current token is already '{')
     consume(TokenType::LEFT_BRACE, "Expect '{' at the beginning of a block.");
 
     // Keep parsing statements until we hit '}'
     while (!check(TokenType::RIGHT_BRACE) && !isAtEnd()) {
-        statements.push_back(parseStatement());  // Parse each statement
+        Stmt* statement = parseStatement();  // Parse each statement
+        blockStack.push_back(statement);
     }
 
     // Consume the '}'
     consume(TokenType::RIGHT_BRACE, "Expect '}' after block.");
 
-    return std::make_unique<BlockStmt>(std::move(statements));
+    // Move this block's statements out of the scratch stack into the arena
+    auto statements = program->arena.copyArray(blockStack.data() + base, blockStack.size() - base);
+    blockStack.resize(base);
+    return make<BlockStmt>(statements);
 }
 // Parse expressions
-std::unique_ptr<Expr> Parser::parseExpression() {
+Expr* Parser::parseExpression() {
     return parseAssignment();
 }
 
 // Handle assignment expressions (`x = 5;`)
-std::unique_ptr<Expr> Parser::parseAssignment() {
-    auto expr = parseEquality();
+Expr* Parser::parseAssignment() {
+    auto expr = parseBinary(Precedence::OR);
 
     if (match(TokenType::EQUAL)) {
-        Token equals = tokens[current - 1];
+        Token equals = previous();
         auto value = parseAssignment();
 
-        if (auto variableExpr = dynamic_cast<VariableExpr*>(expr.get())) {
-            return std::make_unique<AssignExpr>(variableExpr->name, std::move(value));
+        if (expr->kind == ExprKind::VARIABLE) {
+            return make<AssignExpr>(static_cast<VariableExpr*>(expr)->name, value);
         }
 
         error(equals, "Invalid assignment target.");
@@ -182,95 +318,123 @@ std::unique_ptr<Expr> Parser::parseAssignment() {
     return expr;
 }
 
-// Handle `==` and `!=`
-std::unique_ptr<Expr> Parser::parseEquality() {
-    auto expr = parseComparison();
-
-    while (match(TokenType::EQUAL_EQUAL) || match(TokenType::BANG_EQUAL)) {
-        std::string op = tokens[current - 1].lexeme;
-        auto right = parseComparison();
-        expr = std::make_unique<BinaryExpr>(std::move(expr), op, std::move(right));
-    }
-
-    return expr;
+// Binary operators are parsed by precedence climbing over this table,
+// indexed by token type; tokens that aren't binary operators have NONE
+struct InfixRule {
+    Precedence precedence = Precedence::NONE;
+    BinaryOp op = BinaryOp::ADD;
+};
+
+static constexpr auto infixRules = [] {
+    std::array<InfixRule, static_cast<size_t>(TokenType::UNKNOWN) + 1> rules{};
+    auto rule = [&](TokenType type, Precedence precedence, BinaryOp op) {
+        rules[static_cast<size_t>(type)] = {precedence, op};
+    };
+    rule(TokenType::EQUAL_EQUAL, Precedence::EQUALITY, BinaryOp::EQUAL);
+    rule(TokenType::BANG_EQUAL, Precedence::EQUALITY, BinaryOp::NOT_EQUAL);
+    rule(TokenType::GREATER, Precedence::COMPARISON, BinaryOp::GREATER);
+    rule(TokenType::GREATER_EQUAL, Precedence::COMPARISON, BinaryOp::GREATER_EQUAL);
+    rule(TokenType::LESS, Precedence::COMPARISON, BinaryOp::LESS);
+    rule(TokenType::LESS_EQUAL, Precedence::COMPARISON, BinaryOp::LESS_EQUAL);
+    rule(TokenType::PLUS, Precedence::TERM, BinaryOp::ADD);
+    rule(TokenType::MINUS, Precedence::TERM, BinaryOp::SUBTRACT);
+    rule(TokenType::STAR, Precedence::FACTOR, BinaryOp::MULTIPLY);
+    rule(TokenType::SLASH, Precedence::FACTOR, BinaryOp::DIVIDE);
+    return rules;
+}();
+
+static Precedence nextTighter(Precedence precedence) {
+    return static_cast<Precedence>(static_cast<uint8_t>(precedence) + 1);
 }
 
-// Handle `<`, `<=`, `>`, `>=`
-std::unique_ptr<Expr> Parser::parseComparison() {
-    auto expr = parseTerm();
-
-    while (match(TokenType::GREATER) || match(TokenType::GREATER_EQUAL) ||
-           match(TokenType::LESS) || match(TokenType::LESS_EQUAL)) {
-        std::string op = tokens[current - 1].lexeme;
-        auto right = parseTerm();
-        expr = std::make_unique<BinaryExpr>(std::move(expr), op, std::move(right));
-    }
-
-    return expr;
+// `and` and `or` are keywords, so they are told apart by symbol rather than token type
+static Precedence logicalPrecedence(const Token& token) {
+    if (token.type != TokenType::KEYWORD) return Precedence::NONE;
+    if (token.symbol == symbolOf(Keyword::OR)) return Precedence::OR;
+    if (token.symbol == symbolOf(Keyword::AND)) return Precedence::AND;
+    return Precedence::NONE;
 }
 
-// Handle `+` and `-`
-std::unique_ptr<Expr> Parser::parseTerm() {
-    auto expr = parseFactor();
+// Parses operators binding at least as tightly as `minimum`; all are left-associative
+Expr* Parser::parseBinary(Precedence minimum) {
+    auto expr = parseUnary();
+
+    while (true) {
+        Precedence logical = logicalPrecedence(peek());
+        if (logical != Precedence::NONE) {
+            if (logical < minimum) break;
+            int line = advance().line;
+            auto right = parseBinary(nextTighter(logical));
+            expr = make<LogicalExpr>(expr, logical == Precedence::AND, right, line);
+            continue;
+        }
 
-    while (match(TokenType::PLUS) || match(TokenType::MINUS)) {
-        std::string op = tokens[current - 1].lexeme;
-        auto right = parseFactor();
-        expr = std::make_unique<BinaryExpr>(std::move(expr), op, std::move(right));
+        const InfixRule& rule = infixRules[static_cast<size_t>(peek().type)];
+        if (rule.precedence == Precedence::NONE || rule.precedence < minimum) break;
+        int line = advance().line;
+        auto right = parseBinary(nextTighter(rule.precedence));
+        expr = make<BinaryExpr>(expr, rule.op, right, line);
     }
 
     return expr;
 }
 
-// Handle `*` and `/`
-std::unique_ptr<Expr> Parser::parseFactor() {
-    auto expr = parseUnary();
-
-    while (match(TokenType::STAR) || match(TokenType::SLASH)) {
-        std::string op = tokens[current - 1].lexeme;
+// Handle `-` and `!`
+Expr* Parser::parseUnary() {
+    if (match(TokenType::MINUS) || match(TokenType::BANG)) {
+        Token op = previous();
         auto right = parseUnary();
-        expr = std::make_unique<BinaryExpr>(std::move(expr), op, std::move(right));
+        return make<UnaryExpr>(op.type, op.line, right);
     }
 
-    return expr;
+    return parseCall();
 }
 
-// Handle `-` and `!`
-std::unique_ptr<Expr> Parser::parseUnary() {
-    if (match(TokenType::MINUS) || match(TokenType::BANG)) {
-        Token op = tokens[current - 1];
-        auto right = parseUnary();
-        return std::make_unique<UnaryExpr>(op, std::move(right));
+// A primary followed by any number of argument lists: `f(1)(2)`
+Expr* Parser::parseCall() {
+    auto expr = parsePrimary();
+
+    while (match(TokenType::LEFT_PAREN)) {
+        size_t base = argumentStack.size();
+        if (!check(TokenType::RIGHT_PAREN)) {
+            do {
+                if (argumentStack.size() - base >= MAX_ARGUMENTS) {
+                    error(peek(), "Can't have more than 255 arguments.");
+                }
+                argumentStack.push_back(parseExpression());
+            } while (match(TokenType::COMMA));
+        }
+        int line = consume(TokenType::RIGHT_PAREN, "Expect ')' after arguments.").line;
+
+        auto arguments = program->arena.copyArray(argumentStack.data() + base, argumentStack.size() - base);
+        argumentStack.resize(base);
+        expr = make<CallExpr>(expr, arguments, line);
     }
 
-    return parsePrimary();
+    return expr;
 }
 
 // Handles literals, identifiers, and grouping
-std::unique_ptr<Expr> Parser::parsePrimary() {
+Expr* Parser::parsePrimary() {
     if (match(TokenType::NUMBER)) {
-        double value = std::stod(tokens[current - 1].lexeme);
-        return std::make_unique<LiteralExpr>(value);
+        return make<LiteralExpr>(previous().number);  // Parsed by the tokenizer
     } else if (match(TokenType::STRING)) {
-        std::string rawString = tokens[current - 1].lexeme;
-        if (rawString.front() == '"' && rawString.back() == '"') {
-            rawString = rawString.substr(1, rawString.length() - 2);
-        }
-        return std::make_unique<LiteralExpr>(rawString);
+        return make<LiteralExpr>(Value(symbolString(previous().symbol)));  // Shared by every use of the literal
     } else if (match(TokenType::KEYWORD)) {
-        if (tokens[current - 1].lexeme == "true") {
-            return std::make_unique<LiteralExpr>(true);
-        } else if (tokens[current - 1].lexeme == "false") {
-            return std::make_unique<LiteralExpr>(false);
-        } else if (tokens[current - 1].lexeme == "nil") {
-            return std::make_unique<LiteralExpr>(NilValue());
+        Symbol keyword = previous().symbol;
+        if (keyword == symbolOf(Keyword::TRUE)) {
+            return make<LiteralExpr>(true);
+        } else if (keyword == symbolOf(Keyword::FALSE)) {
+            return make<LiteralExpr>(false);
+        } else if (keyword == symbolOf(Keyword::NIL)) {
+            return make<LiteralExpr>(NilValue());
         }
     } else if (match(TokenType::IDENTIFIER)) {
-        return std::make_unique<VariableExpr>(tokens[current - 1].lexeme);  // Handle variables
+        return make<VariableExpr>(previous().symbol);  // Handle variables
     } else if (match(TokenType::LEFT_PAREN)) {
         auto expr = parseExpression();
         consume(TokenType::RIGHT_PAREN, "Expected ')' after expression.");
-        return std::make_unique<GroupingExpr>(std::move(expr));
+        return make<GroupingExpr>(expr);
     }
 
     error(peek(), "Expect expression.");
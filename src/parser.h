@@ -3,42 +3,74 @@
 
 #include <vector>
 #include <memory>
+#include <string_view>
 #include "tokeniser.h"
 #include "ast.h"
 
+// Binding power of binary operators, loosest first
+enum class Precedence : uint8_t { NONE, OR, AND, EQUALITY, COMPARISON, TERM, FACTOR };
+
 class Parser {
 private:
-    std::vector<Token> tokens;
-    size_t current = 0;
+    // Tokens are pulled from the lexer on demand into a small ring buffer
+    // holding the previous token and the lookahead, never the whole file.
+    static constexpr size_t LOOKAHEAD = 4;  // Power of two
+    static constexpr size_t MAX_ARGUMENTS = 255;
+    Lexer& lexer;
+    std::string_view source;  // Buffer the tokens point into
+    Token window[LOOKAHEAD];
+    size_t current = 0;       // Absolute index of the next token to consume
+    size_t filled = 0;        // Tokens pulled from the lexer so far
+    bool consumedEof = false;
     bool isEvaluateMode;
+    std::unique_ptr<Program> program;  // Created up front so nodes can be placed in its arena
+    std::vector<Stmt*> blockStack;     // Scratch space for statements of open blocks
+    std::vector<Expr*> argumentStack;  // Likewise for arguments of open calls
 
 
 
     bool isAtEnd();
-    Token peek();
-    Token advance();
+    const Token& peek();
+    const Token& advance();
+    const Token& previous() const { return window[(current - 1) % LOOKAHEAD]; }
+    std::string_view text(const Token& token) const { return token.lexeme(source); }
     bool match(TokenType type);
     void error(const Token& token, const std::string& message);
-    Token consume(TokenType type, const std::string& message);
+    const Token& consume(TokenType type, const std::string& message);
     bool check(TokenType type);
+    bool checkKeyword(Keyword keyword);
+
+    // Nodes that don't get a line from their constructor take the last token's
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        T* node = program->arena.make<T>(std::forward<Args>(args)...);
+        if (node->line == 0) node->line = previous().line;
+        return node;
+    }
 
-    std::unique_ptr<Stmt> parseStatement();
-    std::unique_ptr<Stmt> parsePrintStatement();
-    std::unique_ptr<Stmt> parseVarDeclaration();
-    std::unique_ptr<Stmt> parseBlock();
-    std::unique_ptr<Stmt> parseIfStmt();
+    Stmt* parseStatement();
+    Stmt* parseStatementBody();
+    Stmt* parseBranch();
+    Stmt* parsePrintStatement();
+    Stmt* parseVarDeclaration();
+    Stmt* parseBlock();
+    Stmt* parseIfStmt();
+    Stmt* parseWhileStmt();
+    Stmt* parseForStmt();
+    Stmt* parseFunction();
+    Stmt* parseReturnStmt();
 
 public:
-   Parser(const std::vector<Token>& tokens, bool isEvaluateMode = false);
+   explicit Parser(Lexer& lexer, bool isEvaluateMode = false);
     std::unique_ptr<Program> parseProgram();
-    std::unique_ptr<Expr> parseExpression();
-    std::unique_ptr<Expr> parseTerm();
-    std::unique_ptr<Expr> parseFactor();
-    std::unique_ptr<Expr> parseUnary();
-    std::unique_ptr<Expr> parsePrimary();
-    std::unique_ptr<Expr> parseComparison();
-    std::unique_ptr<Expr> parseEquality();
-    std::unique_ptr<Expr> parseAssignment();
+    Stmt* parseNext();  // Next top-level statement, or nullptr at end of input
+    Arena& arena() { return program->arena; }
+    Expr* parseExpression();
+    Expr* parseAssignment();
+    Expr* parseBinary(Precedence minimum);
+    Expr* parseUnary();
+    Expr* parseCall();
+    Expr* parsePrimary();
 };
 
 #endif // PARSER_H
\ No newline at end of file
@@ -0,0 +1,174 @@
+#include "perf.h"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+struct CounterSpec {
+    const char* name;
+    uint32_t type;
+    uint64_t config;
+};
+
+const CounterSpec counterSpecs[] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"cache_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"task_clock_ns", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+    {"page_faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+};
+
+int openCounter(const CounterSpec& spec) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof attr);
+    attr.size = sizeof attr;
+    attr.type = spec.type;
+    attr.config = spec.config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;  // Allowed at the default perf_event_paranoid level
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+// Scales for multiplexing when the PMU had more events than counters
+bool readCounter(int fd, uint64_t& value) {
+    uint64_t data[3];  // value, time enabled, time running
+    if (read(fd, data, sizeof data) != static_cast<ssize_t>(sizeof data)) return false;
+    value = data[2] == 0 || data[2] == data[1]
+                ? data[0]
+                : static_cast<uint64_t>(static_cast<double>(data[0]) * data[1] / data[2]);
+    return true;
+}
+
+}  // namespace
+
+static_assert(std::size(counterSpecs) == 6, "keep COUNTERS in sync");
+
+PerfStats::PerfStats(bool enabled, bool json) : isEnabled(enabled), json(json) {
+    for (int i = 0; i < COUNTERS; i++) {
+        fds[i] = enabled ? openCounter(counterSpecs[i]) : -1;
+    }
+}
+
+PerfStats::~PerfStats() {
+    if (isEnabled && !reported) {
+        if (open) {
+            end();
+            phases.back().name += " (aborted)";
+        }
+        report(std::cerr);
+    }
+    for (int fd : fds) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+void PerfStats::begin(const char* phase) {
+    if (!isEnabled) return;
+    Phase entry;
+    entry.name = phase;
+    phases.push_back(std::move(entry));
+    open = true;
+
+    allocationsAtStart = allocationStats();
+    for (int fd : fds) {
+        if (fd < 0) continue;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    start = std::chrono::steady_clock::now();
+}
+
+void PerfStats::end() {
+    if (!isEnabled || !open) return;
+    auto stop = std::chrono::steady_clock::now();
+    for (int fd : fds) {
+        if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+    AllocationStats allocations = allocationStats();
+    open = false;
+
+    Phase& phase = phases.back();
+    phase.wallMs = std::chrono::duration<double, std::milli>(stop - start).count();
+    phase.allocated.allocations = allocations.allocations - allocationsAtStart.allocations;
+    phase.allocated.bytes = allocations.bytes - allocationsAtStart.bytes;
+    for (int i = 0; i < COUNTERS; i++) {
+        phase.counted[i] = fds[i] >= 0 && readCounter(fds[i], phase.counters[i]);
+    }
+}
+
+void PerfStats::report(std::ostream& out) {
+    if (!isEnabled) return;
+    reported = true;
+    if (json) {
+        reportJson(out);
+    } else {
+        reportText(out);
+    }
+}
+
+void PerfStats::reportText(std::ostream& out) const {
+    char buffer[256];
+    std::snprintf(buffer, sizeof buffer, "%-24s %10s %14s %14s %6s %12s %12s %12s %10s %10s %12s\n",
+                  "phase", "wall ms", "cycles", "instructions", "IPC", "branch-miss", "cache-miss",
+                  "task ms", "faults", "allocs", "alloc bytes");
+    out << buffer;
+
+    for (const Phase& phase : phases) {
+        std::string cells[COUNTERS];
+        for (int i = 0; i < COUNTERS; i++) {
+            cells[i] = phase.counted[i] ? std::to_string(phase.counters[i]) : "-";
+        }
+        if (phase.counted[4]) {
+            std::snprintf(buffer, sizeof buffer, "%.3f", phase.counters[4] / 1e6);
+            cells[4] = buffer;
+        }
+        std::string ipc = "-";
+        if (phase.counted[0] && phase.counted[1] && phase.counters[0] > 0) {
+            std::snprintf(buffer, sizeof buffer, "%.2f", static_cast<double>(phase.counters[1]) / phase.counters[0]);
+            ipc = buffer;
+        }
+
+        std::snprintf(buffer, sizeof buffer, "%-24s %10.3f %14s %14s %6s %12s %12s %12s %10s %10llu %12llu\n",
+                      phase.name.c_str(), phase.wallMs, cells[0].c_str(), cells[1].c_str(), ipc.c_str(),
+                      cells[2].c_str(), cells[3].c_str(), cells[4].c_str(), cells[5].c_str(),
+                      static_cast<unsigned long long>(phase.allocated.allocations),
+                      static_cast<unsigned long long>(phase.allocated.bytes));
+        out << buffer;
+    }
+
+    bool missing = false;
+    for (int fd : fds) missing = missing || fd < 0;
+    if (missing) {
+        out << "(-: counter not available here; check perf_event_paranoid or run outside a VM)\n";
+    }
+}
+
+void PerfStats::reportJson(std::ostream& out) const {
+    out << "{\"phases\": [";
+    for (size_t p = 0; p < phases.size(); p++) {
+        const Phase& phase = phases[p];
+        char wall[32];
+        std::snprintf(wall, sizeof wall, "%.6f", phase.wallMs);
+        out << (p ? ", " : "") << "{\"name\": \"" << phase.name << "\", \"wall_ms\": " << wall;
+        for (int i = 0; i < COUNTERS; i++) {
+            out << ", \"" << counterSpecs[i].name << "\": ";
+            if (phase.counted[i]) {
+                out << phase.counters[i];
+            } else {
+                out << "null";
+            }
+        }
+        out << ", \"allocations\": " << phase.allocated.allocations
+            << ", \"allocated_bytes\": " << phase.allocated.bytes << "}";
+    }
+    out << "]}\n";
+}
@@ -0,0 +1,54 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "allocation.h"
+
+// `--perf-stats`: per-phase wall time, allocations and Linux perf_event
+// counters (cycles, instructions, branch and cache misses, task clock,
+// page faults) for this process. Counters the kernel or hypervisor doesn't
+// expose are reported as unavailable instead of failing the run. All
+// methods are no-ops when the stats are disabled.
+class PerfStats {
+public:
+    PerfStats(bool enabled, bool json);
+    // Closes a phase cut short by exit() and reports if report() never ran
+    ~PerfStats();
+
+    PerfStats(const PerfStats&) = delete;
+    PerfStats& operator=(const PerfStats&) = delete;
+
+    bool enabled() const { return isEnabled; }
+    void begin(const char* phase);
+    void end();
+    void report(std::ostream& out);
+
+private:
+    static constexpr int COUNTERS = 6;
+
+    struct Phase {
+        std::string name;
+        double wallMs = 0;
+        uint64_t counters[COUNTERS] = {};
+        bool counted[COUNTERS] = {};
+        AllocationStats allocated;
+    };
+
+    bool isEnabled;
+    bool json;
+    bool reported = false;
+    int fds[COUNTERS];
+    std::vector<Phase> phases;
+    bool open = false;  // A phase has begun but not ended
+    std::chrono::steady_clock::time_point start;
+    AllocationStats allocationsAtStart;
+
+    void reportText(std::ostream& out) const;
+    void reportJson(std::ostream& out) const;
+};
+
+#endif // PERF_H
@@ -0,0 +1,82 @@
+#include "profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+Profiler::~Profiler() {
+    if (!reported) {
+        report(std::cerr);
+    }
+}
+
+void Profiler::leave(Clock::time_point start, int line, uint8_t kind) {
+    uint64_t elapsed = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+    uint64_t children = childTime.back();
+    childTime.pop_back();
+    if (!childTime.empty()) {
+        childTime.back() += elapsed;
+    }
+
+    uint64_t id = static_cast<uint64_t>(static_cast<uint32_t>(line)) << 8 | kind;
+    auto [it, inserted] = entries.try_emplace(id, Entry{line, kind});
+    Entry& entry = it->second;
+    entry.count++;
+    entry.inclusive += elapsed;
+    entry.exclusive += elapsed > children ? elapsed - children : 0;
+}
+
+const char* Profiler::kindName(uint8_t kind) {
+    static const char* const stmtNames[] = {"print", "expression", "var", "assign", "block", "if", "while", "fun", "return"};
+    static const char* const exprNames[] = {"literal", "binary", "grouping", "unary", "variable", "assign expr", "logical", "call"};
+    if (kind < STMT_KINDS) {
+        return kind < std::size(stmtNames) ? stmtNames[kind] : "stmt";
+    }
+    kind -= STMT_KINDS;
+    return kind < std::size(exprNames) ? exprNames[kind] : "expr";
+}
+
+std::string_view Profiler::sourceLine(int line) const {
+    size_t start = 0;
+    for (int i = 1; i < line && start != std::string_view::npos; i++) {
+        start = source.find('\n', start);
+        if (start != std::string_view::npos) start++;
+    }
+    if (start == std::string_view::npos || start >= source.size()) return {};
+
+    std::string_view text = source.substr(start, source.find('\n', start) - start);
+    size_t first = text.find_first_not_of(" \t");
+    return first == std::string_view::npos ? std::string_view() : text.substr(first, 48);
+}
+
+void Profiler::report(std::ostream& out, size_t limit) {
+    reported = true;
+
+    std::vector<const Entry*> rows;
+    uint64_t total = 0;
+    uint64_t executed = 0;
+    for (const auto& [id, entry] : entries) {
+        rows.push_back(&entry);
+        total += entry.exclusive;
+        executed += entry.count;
+    }
+    std::sort(rows.begin(), rows.end(), [](const Entry* a, const Entry* b) {
+        return a->exclusive != b->exclusive ? a->exclusive > b->exclusive : a->line < b->line;
+    });
+    if (rows.size() > limit) rows.resize(limit);
+
+    char buffer[160];
+    std::snprintf(buffer, sizeof buffer, "profile: %llu nodes executed, %.3f ms\n",
+                  static_cast<unsigned long long>(executed), total / 1e6);
+    out << buffer;
+    std::snprintf(buffer, sizeof buffer, "%6s  %-11s %10s %11s %11s %6s  %s\n",
+                  "line", "node", "count", "incl ms", "excl ms", "excl%", "source");
+    out << buffer;
+    for (const Entry* entry : rows) {
+        std::snprintf(buffer, sizeof buffer, "%6d  %-11s %10llu %11.3f %11.3f %5.1f%%  ",
+                      entry->line, kindName(entry->kind), static_cast<unsigned long long>(entry->count),
+                      entry->inclusive / 1e6, entry->exclusive / 1e6,
+                      total ? 100.0 * entry->exclusive / total : 0.0);
+        out << buffer << sourceLine(entry->line) << '\n';
+    }
+}
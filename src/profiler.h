@@ -0,0 +1,58 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+
+// Execution profile for `--profile`. The Evaluator brackets every node it
+// executes with enter()/leave(); samples are aggregated per (source line,
+// node kind), so the AST may be freed while profiling (as `run --stream`
+// does). Inclusive time covers the node and everything it evaluated;
+// exclusive time subtracts the time spent in child nodes.
+class Profiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit Profiler(std::string_view source) : source(source) {}
+    // Reports here if report() was never reached (runtime errors exit())
+    ~Profiler();
+
+    Clock::time_point enter() {
+        childTime.push_back(0);
+        return Clock::now();
+    }
+    void leave(Clock::time_point start, int line, uint8_t kind);
+
+    // Hot spots sorted by exclusive time, at most `limit` rows
+    void report(std::ostream& out, size_t limit = 30);
+
+    // Node kinds share one key space: statements first, then expressions
+    static uint8_t key(StmtKind kind) { return static_cast<uint8_t>(kind); }
+    static uint8_t key(ExprKind kind) { return static_cast<uint8_t>(kind) + STMT_KINDS; }
+
+private:
+    static constexpr uint8_t STMT_KINDS = 16;
+
+    struct Entry {
+        int line;
+        uint8_t kind;
+        uint64_t count = 0;
+        uint64_t inclusive = 0;  // Nanoseconds
+        uint64_t exclusive = 0;
+    };
+
+    std::string_view source;  // Still mapped when the destructor runs from exit()
+    std::unordered_map<uint64_t, Entry> entries;
+    std::vector<uint64_t> childTime;  // Time spent in children of each open node
+    bool reported = false;
+
+    static const char* kindName(uint8_t kind);
+    std::string_view sourceLine(int line) const;
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,178 @@
+#include "resolver.h"
+#include "allocation.h"
+#include <iostream>
+#include <stdexcept>
+
+static void error(int line, std::string_view at, const std::string& message) {
+    std::cerr << "[line " << line << "] Error at '" << at << "': " << message << std::endl;
+    exit(65);
+}
+
+void Resolver::resolve(const std::unique_ptr<Program>& program) {
+    MemoryScope memory(MemoryTag::AST);
+    for (Stmt* stmt : program->statements) {
+        resolveStmt(stmt);
+    }
+}
+
+void Resolver::resolveTopLevel(Stmt* stmt) {
+    MemoryScope memory(MemoryTag::AST);
+    resolveStmt(stmt);
+}
+
+void Resolver::resolveStmt(Stmt* stmt) {
+    switch (stmt->kind) {
+        case StmtKind::PRINT:
+            resolveExpr(static_cast<PrintStmt*>(stmt)->expression);
+            break;
+        case StmtKind::EXPRESSION:
+            resolveExpr(static_cast<ExpressionStmt*>(stmt)->expression);
+            break;
+        case StmtKind::VAR_DECL: {
+            auto varStmt = static_cast<VarDeclStmt*>(stmt);
+            // The initializer is resolved first so `var a = a;` reads the outer `a`
+            if (varStmt->initializer) {
+                resolveExpr(varStmt->initializer);
+            }
+            varStmt->slot = declare(varStmt->name);
+            break;
+        }
+        case StmtKind::FUNCTION: {
+            auto function = static_cast<FunctionStmt*>(stmt);
+            function->slot = declare(function->name);  // Before the body, so it can call itself
+            resolveFunction(function);
+            break;
+        }
+        case StmtKind::RETURN: {
+            auto returnStmt = static_cast<ReturnStmt*>(stmt);
+            if (functionDepth == 0) {
+                error(stmt->line, "return", "Can't return from top-level code.");
+            }
+            if (returnStmt->value) {
+                resolveExpr(returnStmt->value);
+            }
+            break;
+        }
+        case StmtKind::BLOCK:
+            resolveBlock(static_cast<BlockStmt*>(stmt));
+            break;
+        case StmtKind::IF: {
+            auto ifStmt = static_cast<IfStmt*>(stmt);
+            resolveExpr(ifStmt->condition);
+            resolveStmt(ifStmt->thenBranch);
+            if (ifStmt->elseBranch) {
+                resolveStmt(ifStmt->elseBranch);
+            }
+            break;
+        }
+        case StmtKind::WHILE: {
+            auto whileStmt = static_cast<WhileStmt*>(stmt);
+            resolveExpr(whileStmt->condition);
+            resolveStmt(whileStmt->body);
+            if (whileStmt->increment) {
+                resolveExpr(whileStmt->increment);
+            }
+            break;
+        }
+        default:
+            throw std::runtime_error("Unknown statement type.");
+    }
+}
+
+void Resolver::resolveBlock(BlockStmt* stmt) {
+    scopes.push_back({{}, stmt});
+    for (auto& statement : stmt->statements) {
+        resolveStmt(statement);
+    }
+    scopes.pop_back();
+}
+
+// Parameters and the body's top-level locals share the body's scope
+void Resolver::resolveFunction(FunctionStmt* function) {
+    scopes.push_back({{}, function->body});
+    for (Symbol param : function->params) {
+        if (scopes.back().slots.count(param)) {
+            error(function->line, symbolName(param), "Already a variable with this name in this scope.");
+        }
+        declare(param);
+    }
+
+    functionDepth++;
+    for (auto& statement : function->body->statements) {
+        resolveStmt(statement);
+    }
+    functionDepth--;
+    scopes.pop_back();
+}
+
+// Returns the slot for `name` in the innermost scope, or -1 for a global
+int Resolver::declare(Symbol name) {
+    if (scopes.empty()) return -1;  // Globals stay name-based
+
+    Scope& scope = scopes.back();
+    auto it = scope.slots.find(name);
+    if (it != scope.slots.end()) {
+        return it->second;  // Redeclaring in the same block reuses the slot
+    }
+
+    int slot = scope.block->slotCount++;
+    scope.slots.emplace(name, slot);
+    return slot;
+}
+
+void Resolver::resolveExpr(Expr* expr) {
+    switch (expr->kind) {
+        case ExprKind::BINARY: {
+            auto binary = static_cast<BinaryExpr*>(expr);
+            resolveExpr(binary->left);
+            resolveExpr(binary->right);
+            break;
+        }
+        case ExprKind::LOGICAL: {
+            auto logical = static_cast<LogicalExpr*>(expr);
+            resolveExpr(logical->left);
+            resolveExpr(logical->right);
+            break;
+        }
+        case ExprKind::CALL: {
+            auto call = static_cast<CallExpr*>(expr);
+            resolveExpr(call->callee);
+            for (Expr* argument : call->arguments) {
+                resolveExpr(argument);
+            }
+            break;
+        }
+        case ExprKind::LITERAL:
+            break;  // Nothing to resolve
+        case ExprKind::UNARY:
+            resolveExpr(static_cast<UnaryExpr*>(expr)->right);
+            break;
+        case ExprKind::GROUPING:
+            resolveExpr(static_cast<GroupingExpr*>(expr)->expression);
+            break;
+        case ExprKind::VARIABLE: {
+            auto varExpr = static_cast<VariableExpr*>(expr);
+            resolveLocal(varExpr->name, varExpr->depth, varExpr->slot);
+            break;
+        }
+        case ExprKind::ASSIGN: {
+            auto assignExpr = static_cast<AssignExpr*>(expr);
+            resolveExpr(assignExpr->value);
+            resolveLocal(assignExpr->name, assignExpr->depth, assignExpr->slot);
+            break;
+        }
+    }
+}
+
+void Resolver::resolveLocal(Symbol name, int& depth, int& slot) {
+    for (int i = static_cast<int>(scopes.size()) - 1; i >= 0; i--) {
+        auto it = scopes[i].slots.find(name);
+        if (it != scopes[i].slots.end()) {
+            depth = static_cast<int>(scopes.size()) - 1 - i;
+            slot = it->second;
+            return;
+        }
+    }
+    depth = -1;
+    slot = -1;
+}
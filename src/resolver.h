@@ -0,0 +1,37 @@
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+
+// Static pass run between Parser and Evaluator. Annotates every local
+// variable reference with (depth, slot) so the Evaluator can reach it by
+// walking `depth` enclosing environments and indexing `slot`, without
+// hashing names. Anything not found in a block scope is left as a global.
+class Resolver {
+public:
+    void resolve(const std::unique_ptr<Program>& program);
+    // Resolves one top-level statement as it is streamed from the parser
+    void resolveTopLevel(Stmt* stmt);
+
+private:
+    struct Scope {
+        std::unordered_map<Symbol, int> slots;
+        BlockStmt* block;
+    };
+    std::vector<Scope> scopes;
+    int functionDepth = 0;   // Enclosing function bodies, for `return`
+
+    void resolveStmt(Stmt* stmt);
+    void resolveExpr(Expr* expr);
+    void resolveBlock(BlockStmt* stmt);
+    void resolveFunction(FunctionStmt* function);
+    int declare(Symbol name);
+    void resolveLocal(Symbol name, int& depth, int& slot);
+};
+
+#endif // RESOLVER_H
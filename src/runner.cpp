@@ -1,7 +1,29 @@
 #include "runner.h"
+#include "resolver.h"
+#include "optimizer.h"
 
-void Runner::run(const std::unique_ptr<Program>& program) {
+void Runner::run(const std::unique_ptr<Program>& program, Profiler* profiler, int maxCallDepth, const GcConfig& gc) {
     Evaluator evaluator;
+    evaluator.setProfiler(profiler);
+    evaluator.setMaxCallDepth(maxCallDepth);
+    evaluator.setGcConfig(gc);
     evaluator.evaluateProgram(program);
 }
 
+void Runner::runStreaming(Parser& parser, int optLevel, Profiler* profiler, int maxCallDepth, const GcConfig& gc) {
+    Evaluator evaluator;
+    evaluator.setProfiler(profiler);
+    evaluator.setMaxCallDepth(maxCallDepth);
+    evaluator.setGcConfig(gc);
+    Resolver resolver;
+    Optimizer optimizer(optLevel);
+    while (Stmt* stmt = parser.parseNext()) {
+        resolver.resolveTopLevel(stmt);
+        if (Stmt* optimized = optimizer.optimizeTopLevel(stmt, parser.arena())) {
+            evaluator.evaluateStmt(optimized);
+        }
+        if (!evaluator.hasCreatedFunctions()) {
+            parser.arena().reset();  // No runtime value points into the AST yet
+        }
+    }
+}
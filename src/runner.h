@@ -2,12 +2,19 @@
 #define RUNNER_H
 
 #include "evaluator.h"
+#include "parser.h"
 #include <vector>
 #include <memory>
 
 class Runner {
 public:
-    void run(const std::unique_ptr<Program>& program );
+    void run(const std::unique_ptr<Program>& program, Profiler* profiler = nullptr,
+             int maxCallDepth = Evaluator::DEFAULT_MAX_CALL_DEPTH, const GcConfig& gc = {});
+    // Parses, resolves and executes one top-level statement at a time. Each
+    // statement's AST is released once it has run, so memory stays bounded,
+    // until a function is declared: function values keep pointing into it.
+    void runStreaming(Parser& parser, int optLevel, Profiler* profiler = nullptr,
+                      int maxCallDepth = Evaluator::DEFAULT_MAX_CALL_DEPTH, const GcConfig& gc = {});
 };
 
 #endif // RUNNER_H
\ No newline at end of file
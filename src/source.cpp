@@ -0,0 +1,68 @@
+#include "source.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SourceBuffer::~SourceBuffer() {
+    if (mapping != nullptr) {
+        munmap(mapping, size);
+    }
+}
+
+bool SourceBuffer::load(const std::string& filename) {
+    if (filename == "-") {
+        return readStream(STDIN_FILENO);
+    }
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return false;
+    }
+
+    if (!S_ISREG(info.st_mode)) {
+        bool ok = readStream(fd);  // FIFOs, character devices, ...
+        close(fd);
+        return ok;
+    }
+
+    if (info.st_size == 0) {
+        close(fd);  // mmap rejects empty ranges; the default view is already empty
+        return true;
+    }
+
+    void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        bool ok = readStream(fd);
+        close(fd);
+        return ok;
+    }
+    close(fd);  // The mapping stays valid after the descriptor is closed
+
+    madvise(mapped, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+    mapping = mapped;
+    data = static_cast<const char*>(mapped);
+    size = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+bool SourceBuffer::readStream(int fd) {
+    char chunk[64 * 1024];
+    for (;;) {
+        ssize_t count = read(fd, chunk, sizeof chunk);
+        if (count == 0) break;
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        fallback.append(chunk, static_cast<size_t>(count));
+    }
+    data = fallback.data();
+    size = fallback.size();
+    return true;
+}
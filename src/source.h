@@ -0,0 +1,32 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only view of a script's bytes. Regular files are memory-mapped, so
+// the tokenizer reads the page cache directly; stdin ("-"), pipes and
+// anything that cannot be mapped fall back to reading into a string.
+class SourceBuffer {
+public:
+    SourceBuffer() = default;
+    ~SourceBuffer();
+
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+    bool load(const std::string& filename);
+
+    std::string_view view() const { return {data, size}; }
+
+private:
+    const char* data = "";
+    size_t size = 0;
+    void* mapping = nullptr;
+    std::string fallback;
+
+    bool readStream(int fd);
+};
+
+#endif // SOURCE_H
@@ -0,0 +1,51 @@
+#include "symbol.h"
+#include "allocation.h"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct SymbolTable {
+    std::vector<std::unique_ptr<StringBuffer>> strings;  // Indexed by symbol
+    std::unordered_map<std::string_view, Symbol> symbols;     // Keys view into `strings`
+
+    SymbolTable() {
+        for (std::string_view keyword : {"and", "class", "else", "false", "for", "fun", "if", "nil",
+                                         "or", "print", "return", "super", "this", "true", "var", "while"}) {
+            add(keyword);
+        }
+    }
+
+    // Whoever interns first pays: the lexer for names and literals, the
+    // optimizer for folded strings
+    Symbol add(std::string_view text) {
+        MemoryScope memory(MemoryTag::SYMBOLS);
+        Symbol symbol = static_cast<Symbol>(strings.size());
+        strings.push_back(std::make_unique<StringBuffer>(std::string(text), true));
+        symbols.emplace(strings.back()->text, symbol);
+        return symbol;
+    }
+};
+
+// Built on first use so lexing during static initialisation is safe
+SymbolTable& table() {
+    static SymbolTable instance;
+    return instance;
+}
+
+}  // namespace
+
+Symbol intern(std::string_view text) {
+    SymbolTable& symbols = table();
+    auto it = symbols.symbols.find(text);
+    return it != symbols.symbols.end() ? it->second : symbols.add(text);
+}
+
+std::string_view symbolName(Symbol symbol) {
+    return table().strings[symbol]->text;
+}
+
+StringBuffer* symbolString(Symbol symbol) {
+    return table().strings[symbol].get();
+}
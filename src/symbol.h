@@ -0,0 +1,30 @@
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "value.h"
+
+// Interned text. The lexer maps every identifier, keyword and string literal
+// to a small integer once; later passes compare and hash those integers and
+// only go back to the text to display it. The table lives for the process,
+// so symbols stay valid across the statements of a streamed run.
+using Symbol = uint32_t;
+
+// Interned first, in this order, so their symbols are constants
+enum class Keyword : Symbol {
+    AND, CLASS, ELSE, FALSE, FOR, FUN, IF, NIL, OR, PRINT, RETURN, SUPER, THIS, TRUE, VAR, WHILE,
+    COUNT
+};
+
+constexpr Symbol symbolOf(Keyword keyword) { return static_cast<Symbol>(keyword); }
+constexpr bool isKeyword(Symbol symbol) { return symbol < symbolOf(Keyword::COUNT); }
+
+Symbol intern(std::string_view text);
+std::string_view symbolName(Symbol symbol);
+// The text as a frozen runtime string: every use of the same literal shares
+// it, and it belongs to the table rather than to any Heap
+StringBuffer* symbolString(Symbol symbol);
+
+#endif // SYMBOL_H
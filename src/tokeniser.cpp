@@ -1,211 +1,143 @@
 #include "tokeniser.h"
+#include "value.h"
 #include <cctype>
-#include <algorithm>
-#include <sstream>
-#include <fstream>
+#include <charconv>
 
 using namespace std;
 
-unordered_set<string> keywords={"and","class","else","false","for","fun","if","nil","or","print","return","super","this","true","var","while"};
-// function for scanning identifiers 
-vector<Token> scannedIdentifier( const string &input, int &i, int &line) {
-    vector<Token> tokens;
-    string identifier = "";
-
-    // Check for the initials
-    if (isalpha(input[i]) || input[i] == '_') {
-        identifier += input[i];
-        i++;
-        while (i < input.length() && (isalnum(input[i]) || input[i] == '_')) {
-            identifier += input[i];
-           
-            i++;
-        }
-
-      
+static bool isIdentifierStart(char ch) {
+    return isalpha(static_cast<unsigned char>(ch)) || ch == '_';
+}
 
-        if (keywords.find(identifier) != keywords.end() ) {
-            tokens.push_back(Token(TokenType::KEYWORD, identifier, "null", line)); // Add keyword token
-        } else {
-            tokens.push_back(Token(TokenType::IDENTIFIER, identifier, "null", line)); // Add identifier token
-        }
-    }
-    i--; // Adjust index after scanning
-    return tokens;
+static bool isIdentifierChar(char ch) {
+    return isalnum(static_cast<unsigned char>(ch)) || ch == '_';
 }
 
-int tokenize(const std::string& file_contents ,std::vector<Token>& tokens){
-        bool haderror=false ;
-        int line=1;
-        
-        // Uncomment this block to pass the first stage
-        // 
-        if (!file_contents.empty()) {
-
-            for (int  i = 0; i < file_contents.length(); i++) {
-                char ch = file_contents[i];
-        
-                switch (ch) {
-                    case '(': tokens.push_back(Token(TokenType::LEFT_PAREN, "(", "null", line)); break;
-                case ')': tokens.push_back(Token(TokenType::RIGHT_PAREN, ")", "null", line)); break;
-                case '{': tokens.push_back(Token(TokenType::LEFT_BRACE, "{", "null", line)); break;
-                case '}': tokens.push_back(Token(TokenType::RIGHT_BRACE, "}", "null", line)); break;
-                case ',': tokens.push_back(Token(TokenType::COMMA, ",", "null", line)); break;
-                case '.': tokens.push_back(Token(TokenType::DOT, ".", "null", line)); break;
-                case '-': tokens.push_back(Token(TokenType::MINUS, "-", "null", line)); break;
-                case '+': tokens.push_back(Token(TokenType::PLUS, "+", "null", line)); break;
-                case ';': tokens.push_back(Token(TokenType::SEMICOLON, ";", "null", line)); break;
-                case '*': tokens.push_back(Token(TokenType::STAR, "*", "null", line)); break;
-                    //case '\n': line++; break; // Increment line number on newline
-                    
-                    // Handling `=` and `==`
-                    case '=':
-                        if (i + 1 < file_contents.length() && file_contents[i + 1] == '=') {
-                            tokens.push_back(Token(TokenType::EQUAL_EQUAL, "==", "null", line));
-                            i++; // Skip next character since we already consumed it
-                        } else {
-                            tokens.push_back(Token(TokenType::EQUAL, "=", "null", line));
-                        }
+Token Lexer::next(){
+        const std::string_view& file_contents = source;
+        const size_t length = file_contents.length();
+
+        while (pos < length) {
+            size_t i = pos;
+            char ch = file_contents[i];
+            bool nextIsEqual = i + 1 < length && file_contents[i + 1] == '=';
+            pos = i + 1;
+
+            // Single-character tokens are returned with their offset; no text is copied
+            switch (ch) {
+                case '(': return make(TokenType::LEFT_PAREN, i, 1);
+                case ')': return make(TokenType::RIGHT_PAREN, i, 1);
+                case '{': return make(TokenType::LEFT_BRACE, i, 1);
+                case '}': return make(TokenType::RIGHT_BRACE, i, 1);
+                case ',': return make(TokenType::COMMA, i, 1);
+                case '.': return make(TokenType::DOT, i, 1);
+                case '-': return make(TokenType::MINUS, i, 1);
+                case '+': return make(TokenType::PLUS, i, 1);
+                case ';': return make(TokenType::SEMICOLON, i, 1);
+                case '*': return make(TokenType::STAR, i, 1);
+
+                // Handling `=` and `==` (and the other two-character operators)
+                case '=':
+                    if (nextIsEqual) { pos++; return make(TokenType::EQUAL_EQUAL, i, 2); }
+                    return make(TokenType::EQUAL, i, 1);
+                case '!':
+                    if (nextIsEqual) { pos++; return make(TokenType::BANG_EQUAL, i, 2); }
+                    return make(TokenType::BANG, i, 1);
+                case '<':
+                    if (nextIsEqual) { pos++; return make(TokenType::LESS_EQUAL, i, 2); }
+                    return make(TokenType::LESS, i, 1);
+                case '>':
+                    if (nextIsEqual) { pos++; return make(TokenType::GREATER_EQUAL, i, 2); }
+                    return make(TokenType::GREATER, i, 1);
+
+                case '/':
+                    if(i+1<length && file_contents[i+1]=='/'){
+                        // we have to skip everything until the end of the line
+                        size_t newline = file_contents.find('\n', i);
+                        pos = newline == string_view::npos ? length : newline + 1;
+                        line++;
                         break;
-        
-                    case '!':
-                        if(i+1<file_contents.length() && file_contents[i+1]=='='){
-                            tokens.push_back(Token(TokenType::BANG_EQUAL, "!=", "null", line));
-                            i++;
-                            break;
-                        }
-                        else {
-                            tokens.push_back(Token(TokenType::BANG, "!", "null", line));
-                            break;
-                        }
-
-                    case '<':
-                        if(i+1<file_contents.length() && file_contents[i+1]=='='){
-                            tokens.push_back(Token(TokenType::LESS_EQUAL, "<=", "null", line));
-                            i++;
-                            break;
-                        }
-                        else {
-                            tokens.push_back(Token(TokenType::LESS, "<", "null", line));
-                            break;
-                        }
-
-                    case '>':
-                        if(i+1<file_contents.length() && file_contents[i+1]=='='){
-                            tokens.push_back(Token(TokenType::GREATER_EQUAL, ">=", "null", line));
-                            i++;
-                            break;
-                        }
-                        else {
-                            tokens.push_back(Token(TokenType::GREATER, ">", "null", line));
-                            break;
+                    }
+                    return make(TokenType::SLASH, i, 1);
+
+                case ' ': break;
+                case '\t':break;
+                case '\n':
+                    line++;
+                    break;
+
+                // scanning the string literal; the lexeme keeps its quotes
+                case '"':{
+                    size_t start = i;
+                    i++;
+                    while(i<length && file_contents[i]!='"'){
+                        if(file_contents[i]=='\n'){
+                            line++;
                         }
+                        i++;
+                    }
 
-                    case '/':
-                        if(i+1<file_contents.length() && file_contents[i+1]=='/'){
-                            i++;
-                            // we have to skip everything 
-                           while(i<file_contents.length() && file_contents[i]!='\n'){
-                                i++;
-                           }
-                           line++;
-                        }
-                        else {
-                            tokens.push_back(Token(TokenType::SLASH, "/", "null", line));
-                            
-                        }
+                    if(i>=length){
+                        haderror=true;
+                        cerr << "[line " << line << "] Error: Unterminated string." << endl;
+                        pos = length;
                         break;
+                    }
 
-                    case ' ': break;
-                    case '\t':break;
-                    case '\n':
-                        line++;
-                        break;
+                    pos = i + 1;
+                    return makeSymbol(TokenType::STRING, start, i - start + 1,
+                                      file_contents.substr(start + 1, i - start - 1));
+                }
 
-                    // scanning the string literal 
-                    case '"':{
-                        string s="";
-                        i++;
-                        while(i<file_contents.length() && file_contents[i]!='"'){
-                            if(file_contents[i]=='\n'){
-                                line++;
-                            }
-                            s.push_back(file_contents[i]);
-                            i++;
-                        }
+                case '0': case '1': case '2': case '3': case '4':
+                case '5': case '6': case '7': case '8': case '9': {
+                    size_t start = i;
+                    bool hasDecimal = false;
 
-                        if(i>=file_contents.length()){
-                            haderror=true;
-                            cerr << "[line " << line << "] Error: Unterminated string." << endl;
-                            
-                            break;
+                    while (i < length && (isdigit(static_cast<unsigned char>(file_contents[i])) || file_contents[i] == '.')) {
+                        if (file_contents[i] == '.') {
+                            if (hasDecimal) break; // Prevent multiple decimal points
+                            hasDecimal = true;
                         }
-
-                        tokens.push_back(Token(TokenType::STRING, "\"" + s + "\"", s, line));
-                        break;
+                        i++;
                     }
 
-                    case '0': case '1': case '2': case '3': case '4':
-                    case '5': case '6': case '7': case '8': case '9': {
-                        string num;
+                    double value = 0.0;
+                    std::from_chars(file_contents.data() + start, file_contents.data() + i, value);
+                    pos = i;
+                    return Token(TokenType::NUMBER, static_cast<uint32_t>(start),
+                                 static_cast<uint32_t>(i - start), line, value);
+                }
+
+                default:
+                    if(isIdentifierStart(ch)){
                         size_t start = i;
-                        bool hasDecimal = false;
-        
-                        while (i < file_contents.length() && (isdigit(file_contents[i]) || file_contents[i] == '.')) {
-                            if (file_contents[i] == '.') {
-                                if (hasDecimal) break; // Prevent multiple decimal points
-                                hasDecimal = true;
-                            }
-                            num += file_contents[i];
+                        while (i + 1 < length && isIdentifierChar(file_contents[i + 1])) {
                             i++;
                         }
-                        i--; // Roll back one step as loop overshoots
-        
-                        
-                        bool isInteger = true;
-                        string decimalPart;
-                        if (hasDecimal) {
-                            size_t decimalPos = num.find('.');
-                            decimalPart = num.substr(decimalPos + 1);
-                            for (char c : decimalPart) {
-                                if (c != '0') {
-                                    isInteger = false;
-                                    break;
-                                }
-                            }
-                        }
-                        string literal;
-                        if (isInteger) {
-                            // Print as an integer
-                            literal = to_string(stoi(num)) + ".0";
-                        } else {
-                            // Print as a floating-point number with the original precision
-                            literal = to_string(stoi(num)) + "." + decimalPart ;
-                        }
-
-                        tokens.push_back(Token(TokenType::NUMBER,num,literal,line));
-                        break;
+                        size_t size = i - start + 1;
+                        pos = i + 1;
+                        Token token = makeSymbol(TokenType::IDENTIFIER, start, size, file_contents.substr(start, size));
+                        if (isKeyword(token.symbol)) token.type = TokenType::KEYWORD;
+                        return token;
                     }
-
-
-                        
-                    default:
-                        if(isalpha(ch)|| ch=='_'){
-                            vector<Token> idTokens = scannedIdentifier(file_contents, i, line);
-                            tokens.insert(tokens.end(), idTokens.begin(), idTokens.end());  
-                        }
-                        else {
-                            cerr << "[line "<<line <<"] Error: Unexpected character: " << ch << endl;
-                            haderror = true;
-                             
-                        }
-                        break;
-                }
+                    cerr << "[line "<<line <<"] Error: Unexpected character: " << ch << endl;
+                    haderror = true;
+                    break;
             }
-            tokens.push_back(Token(TokenType::EOF_TOKEN, "", "null", line));
-            return haderror ? 65 : 0;
         }
-        tokens.push_back(Token(TokenType::EOF_TOKEN, "", "null", line));
-        return 0;
-        
-}
\ No newline at end of file
+        return make(TokenType::EOF_TOKEN, length, 0);
+}
+
+std::string tokenLiteral(const Token& token, std::string_view source) {
+    std::string_view lexeme = token.lexeme(source);
+
+    if (token.type == TokenType::STRING) {
+        return std::string(lexeme.substr(1, lexeme.size() - 2));
+    }
+    if (token.type != TokenType::NUMBER) {
+        return "null";
+    }
+
+    return formatNumber(token.number, NumberFormat::LITERAL);  // "1" -> "1.0", "0.50" -> "0.5"
+}
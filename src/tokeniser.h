@@ -1,12 +1,13 @@
 #ifndef TOKENIZER_H
 #define TOKENIZER_H
 
+#include <cstdint>
 #include <iostream>
 #include <string>
-#include <unordered_set>
-#include <vector> 
+#include <string_view>
+#include "symbol.h"
 
-enum class TokenType {
+enum class TokenType : uint8_t {
     IDENTIFIER, KEYWORD, NUMBER, STRING,
     LEFT_PAREN, RIGHT_PAREN, LEFT_BRACE, RIGHT_BRACE,
     COMMA, DOT, MINUS, PLUS, SEMICOLON, STAR, SLASH,
@@ -15,16 +16,55 @@ enum class TokenType {
     EOF_TOKEN, ERROR,TRUE,FALSE,NIL,UNKNOWN
 };
 
+// Tokens do not own text: they point into the source buffer, which must
+// outlive them. NUMBER tokens carry their value already parsed; identifiers,
+// keywords and strings (without the quotes) carry their interned symbol.
 struct Token {
-    TokenType type;
-    std::string lexeme;
-    std::string literal;
-    int line;
+    TokenType type = TokenType::EOF_TOKEN;
+    uint32_t start = 0;   // Byte offset of the lexeme in the source
+    uint32_t length = 0;
+    int line = 1;
+    union {
+        double number = 0.0;
+        Symbol symbol;
+    };
 
-    Token(TokenType type, std::string lexeme, std::string literal, int line)
-        : type(type), lexeme(lexeme), literal(literal), line(line) {}
+    Token() = default;
+    Token(TokenType type, uint32_t start, uint32_t length, int line, double number = 0.0)
+        : type(type), start(start), length(length), line(line), number(number) {}
+
+    std::string_view lexeme(std::string_view source) const { return source.substr(start, length); }
+};
+
+// Pull-based scanner: produces one token per call to next(), so callers can
+// parse (and run) a script without ever materialising its token vector.
+// Lexical errors are reported to stderr as they are found; after the end of
+// input every call returns an EOF token.
+class Lexer {
+public:
+    explicit Lexer(std::string_view source) : source(source) {}
+
+    Token next();
+    bool hadError() const { return haderror; }
+    std::string_view text() const { return source; }
+
+private:
+    std::string_view source;
+    size_t pos = 0;
+    int line = 1;
+    bool haderror = false;
+
+    Token make(TokenType type, size_t start, size_t size) const {
+        return Token(type, static_cast<uint32_t>(start), static_cast<uint32_t>(size), line);
+    }
+    Token makeSymbol(TokenType type, size_t start, size_t size, std::string_view text) const {
+        Token token = make(type, start, size);
+        token.symbol = intern(text);
+        return token;
+    }
 };
 
-int tokenize(const std::string& file_contents ,std::vector<Token>& tokens);
+// The literal column of `tokenize` output: string contents, normalised number, or "null"
+std::string tokenLiteral(const Token& token, std::string_view source);
 
 #endif // TOKENIZER_H
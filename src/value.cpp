@@ -0,0 +1,103 @@
+#include "value.h"
+#include "closure.h"
+#include "function.h"
+#include "heap.h"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+bool isTruthy(const Value& value) {
+    switch (value.type) {
+        case ValueType::NIL: return false;
+        case ValueType::BOOL: return value.boolean;
+        case ValueType::NUMBER: return value.number != 0.0;
+        case ValueType::STRING: return true;
+        case ValueType::FUNCTION: return true;
+    }
+    return false;
+}
+
+bool valuesEqual(const Value& left, const Value& right) {
+    if (left.type != right.type) return false;
+
+    switch (left.type) {
+        case ValueType::NIL: return true;
+        case ValueType::BOOL: return left.boolean == right.boolean;
+        case ValueType::NUMBER: return left.number == right.number;
+        case ValueType::STRING:
+            return (left.object == right.object && left.length == right.length) ||
+                   left.asString() == right.asString();
+        case ValueType::FUNCTION: return left.object == right.object;
+    }
+    return false;
+}
+
+Value concatenate(Heap& heap, const Value& left, const Value& right) {
+    StringBuffer& buffer = left.buffer();
+    if (!buffer.frozen && left.length == buffer.text.size()) {
+        size_t capacity = buffer.text.capacity();
+        buffer.text.append(right.asString());  // Safe when `right` views this buffer too
+        heap.grew(buffer.text.capacity() - capacity);
+        return Value(&buffer);
+    }
+
+    std::string text;
+    text.reserve(left.length + right.length);
+    text.append(left.asString());
+    text.append(right.asString());
+    return Value(heap.make<StringBuffer>(std::move(text)));
+}
+
+size_t formatNumber(double num, char* out, NumberFormat format) {
+    // Spelled out here rather than by to_chars, whose NaN sign and case
+    // follow the platform; these are the names Lox has always used
+    if (!std::isfinite(num)) {
+        std::string_view text = std::isnan(num) ? "NaN" : num > 0 ? "Infinity" : "-Infinity";
+        std::memcpy(out, text.data(), text.size());
+        return text.size();
+    }
+
+    // Fixed notation never needs an exponent; the shortest digits that read
+    // back as `num` can still span ~330 characters for extreme magnitudes
+    auto result = std::to_chars(out, out + NUMBER_BUFFER_SIZE - 2, num, std::chars_format::fixed);
+    size_t length = static_cast<size_t>(result.ptr - out);
+
+    if (format == NumberFormat::LITERAL && std::memchr(out, '.', length) == nullptr) {
+        out[length++] = '.';
+        out[length++] = '0';
+    }
+    return length;
+}
+
+std::string formatNumber(double num, NumberFormat format) {
+    char buffer[NUMBER_BUFFER_SIZE];
+    return std::string(buffer, formatNumber(num, buffer, format));
+}
+
+std::string stringify(const Value& value) {
+    switch (value.type) {
+        case ValueType::NIL: return "nil";
+        case ValueType::BOOL: return value.boolean ? "true" : "false";
+        case ValueType::NUMBER: return formatNumber(value.number);
+        case ValueType::STRING: return std::string(value.asString());
+        case ValueType::FUNCTION: {
+            Symbol name = value.object->type == ObjectType::CLOSURE ? asClosure(value).function->name
+                                                                    : asFunction(value).declaration->name;
+            return "<fn " + std::string(symbolName(name)) + ">";
+        }
+    }
+    return "Unknown";
+}
+
+void printValue(std::ostream& out, const Value& value) {
+    if (value.isString()) {
+        std::string_view text = value.asString();
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    } else if (value.isNumber()) {
+        char buffer[NUMBER_BUFFER_SIZE];
+        out.write(buffer, static_cast<std::streamsize>(formatNumber(value.number, buffer)));
+    } else {
+        out << stringify(value);
+    }
+    out << '\n';
+}
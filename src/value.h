@@ -0,0 +1,103 @@
+#ifndef VALUE_H
+#define VALUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+class NilValue {
+    public:
+        bool operator==(const NilValue&) const { return true; }  // All NilValues are equal
+        bool operator!=(const NilValue&) const { return false; } // Nil is never different from another Nil
+
+        friend std::ostream& operator<<(std::ostream& os, const NilValue&) {
+            return os << "nil";
+        }
+    };
+
+enum class ValueType { NIL, BOOL, NUMBER, STRING, FUNCTION };
+
+enum class ObjectType : uint8_t { STRING, FUNCTION, ENVIRONMENT, CLOSURE, UPVALUE };
+
+// Heap data a Value can refer to: a StringBuffer, a Function (function.h),
+// an Environment, or the VM's Closure and Upvalue (closure.h). Objects made
+// by a Heap (heap.h) are chained through `next` and freed by its collector;
+// interned strings live outside any heap.
+struct Object {
+    ObjectType type;
+    bool marked = false;
+    Object* next = nullptr;
+
+    explicit Object(ObjectType type) : type(type) {}
+};
+
+// Text behind string values. A string Value sees only the first `length`
+// bytes of its buffer, and bytes a Value can see never change, so a buffer
+// can be shared by values of different lengths and grown at the end.
+struct StringBuffer : Object {
+    std::string text;
+    bool frozen = false;  // Never appended to (interned literals)
+
+    explicit StringBuffer(std::string text, bool frozen = false)
+        : Object(ObjectType::STRING), text(std::move(text)), frozen(frozen) {}
+};
+
+// Runtime value produced by the evaluator. Numbers and booleans live inline,
+// strings and functions are plain pointers to objects a Heap keeps alive, so
+// copying a Value never touches them.
+class Value {
+public:
+    ValueType type = ValueType::NIL;
+    union {
+        bool boolean;
+        double number = 0.0;
+        size_t length;  // STRING: bytes of the buffer this value covers
+    };
+    Object* object = nullptr;  // Set for STRING and FUNCTION
+
+    Value() = default;
+    Value(NilValue) {}
+    explicit Value(bool value) : type(ValueType::BOOL), boolean(value) {}
+    explicit Value(double value) : type(ValueType::NUMBER), number(value) {}
+    explicit Value(StringBuffer* buffer)  // Covers the whole buffer as it is now
+        : type(ValueType::STRING), length(buffer->text.size()), object(buffer) {}
+    Value(ValueType type, Object* object) : type(type), object(object) {}
+
+    bool isNil() const { return type == ValueType::NIL; }
+    bool isBool() const { return type == ValueType::BOOL; }
+    bool isNumber() const { return type == ValueType::NUMBER; }
+    bool isString() const { return type == ValueType::STRING; }
+    bool isFunction() const { return type == ValueType::FUNCTION; }
+
+    StringBuffer& buffer() const { return *static_cast<StringBuffer*>(object); }
+    std::string_view asString() const { return {buffer().text.data(), length}; }
+};
+
+bool isTruthy(const Value& value);
+bool valuesEqual(const Value& left, const Value& right);
+
+class Heap;
+
+// String `+`. When `left` covers its whole buffer, `right` is appended to
+// that buffer in place, so building a string by repeated appends costs
+// amortized O(length of the appended part) rather than a full copy each time.
+// A new buffer comes from `heap`.
+Value concatenate(Heap& heap, const Value& left, const Value& right);
+
+// Formatting only happens when a value is shown to the user (print/evaluate).
+// Numbers are shown as the shortest fixed-notation text that reads back as
+// the same double. PLAIN is what `print` shows ("3", "0.1"); LITERAL keeps a
+// fraction on integers ("3.0"), as `parse` and `tokenize` display literals.
+enum class NumberFormat { PLAIN, LITERAL };
+constexpr size_t NUMBER_BUFFER_SIZE = 400;
+
+size_t formatNumber(double num, char* out, NumberFormat format = NumberFormat::PLAIN);
+std::string formatNumber(double num, NumberFormat format = NumberFormat::PLAIN);
+std::string stringify(const Value& value);
+// What `print` writes, without building an intermediate string
+void printValue(std::ostream& out, const Value& value);
+
+#endif // VALUE_H
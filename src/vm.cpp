@@ -0,0 +1,281 @@
+#include "vm.h"
+#include "allocation.h"
+#include "evaluator.h"
+#include <iostream>
+
+VM::VM(GcConfig gc) : heap(gc), maxCallDepth(Evaluator::DEFAULT_MAX_CALL_DEPTH) {}
+
+void VM::run(const Chunk& chunk) {
+    const uint8_t* code = chunk.code.data();
+    const uint8_t* ip = code;
+    Closure* closure = nullptr;  // Running function; nullptr at the top level
+    size_t base = 0;             // Where its local slots start
+
+    globals.assign(chunk.globalNames.size(), Value());
+    defined.assign(chunk.globalNames.size(), false);
+    stack.clear();
+    stack.reserve(256);
+    frames.clear();
+    openUpvalues.clear();
+
+    auto readShort = [&ip]() {
+        uint16_t value = static_cast<uint16_t>((ip[0] << 8) | ip[1]);
+        ip += 2;
+        return value;
+    };
+    auto readLong = [&ip]() {
+        uint32_t value = (static_cast<uint32_t>(ip[0]) << 16) | (static_cast<uint32_t>(ip[1]) << 8) | ip[2];
+        ip += 3;
+        return value;
+    };
+    // Offset of the instruction currently executing, for the line table
+    auto currentOffset = [&]() { return static_cast<size_t>(ip - code - 1); };
+
+    for (;;) {
+        OpCode instruction = static_cast<OpCode>(*ip++);
+        switch (instruction) {
+            case OpCode::CONSTANT:
+                stack.push_back(chunk.constants[readLong()]);
+                break;
+            case OpCode::NIL: stack.emplace_back(); break;
+            case OpCode::TRUE: stack.emplace_back(true); break;
+            case OpCode::FALSE: stack.emplace_back(false); break;
+            case OpCode::POP: stack.pop_back(); break;
+            case OpCode::POPN: {
+                uint16_t count = readShort();
+                stack.resize(stack.size() - count);
+                break;
+            }
+            case OpCode::GET_LOCAL:
+                stack.push_back(stack[base + readShort()]);
+                break;
+            case OpCode::SET_LOCAL:
+                stack[base + readShort()] = stack.back();
+                break;
+            case OpCode::GET_UPVALUE: {
+                Value value = closure->upvalues[readShort()]->value(stack);
+                stack.push_back(value);
+                break;
+            }
+            case OpCode::SET_UPVALUE:
+                closure->upvalues[readShort()]->value(stack) = stack.back();
+                break;
+            case OpCode::GET_GLOBAL: {
+                uint32_t slot = readLong();
+                if (!defined[slot]) {
+                    std::cerr << "Undefined variable '" << chunk.globalNames[slot] << "'" << std::endl;
+                    exit(70);
+                }
+                stack.push_back(globals[slot]);
+                break;
+            }
+            case OpCode::DEFINE_GLOBAL: {
+                uint32_t slot = readLong();
+                globals[slot] = std::move(stack.back());
+                defined[slot] = true;
+                stack.pop_back();
+                break;
+            }
+            case OpCode::SET_GLOBAL: {
+                uint32_t slot = readLong();
+                if (!defined[slot]) {
+                    std::cerr << "Undefined variable '" << chunk.globalNames[slot] << "'" << std::endl;
+                    exit(70);
+                }
+                globals[slot] = stack.back();
+                break;
+            }
+            case OpCode::EQUAL: {
+                bool equal = valuesEqual(stack[stack.size() - 2], stack.back());
+                stack.pop_back();
+                stack.back() = Value(equal);
+                break;
+            }
+            case OpCode::NOT_EQUAL: {
+                bool equal = valuesEqual(stack[stack.size() - 2], stack.back());
+                stack.pop_back();
+                stack.back() = Value(!equal);
+                break;
+            }
+            case OpCode::GREATER:
+            case OpCode::GREATER_EQUAL:
+            case OpCode::LESS:
+            case OpCode::LESS_EQUAL:
+            case OpCode::SUBTRACT:
+            case OpCode::MULTIPLY:
+            case OpCode::DIVIDE: {
+                Value& left = stack[stack.size() - 2];
+                const Value& right = stack.back();
+                if (!left.isNumber() || !right.isNumber()) {
+                    runtimeError(chunk, currentOffset(), "Operands must be numbers. ");
+                }
+                double a = left.number;
+                double b = right.number;
+                Value result;
+                switch (instruction) {
+                    case OpCode::GREATER: result = Value(a > b); break;
+                    case OpCode::GREATER_EQUAL: result = Value(a >= b); break;
+                    case OpCode::LESS: result = Value(a < b); break;
+                    case OpCode::LESS_EQUAL: result = Value(a <= b); break;
+                    case OpCode::SUBTRACT: result = Value(a - b); break;
+                    case OpCode::MULTIPLY: result = Value(a * b); break;
+                    default: result = Value(a / b); break;
+                }
+                stack.pop_back();
+                left = result;
+                break;
+            }
+            case OpCode::ADD: {
+                Value& left = stack[stack.size() - 2];
+                const Value& right = stack.back();
+                if (left.isNumber() && right.isNumber()) {
+                    left.number += right.number;
+                } else if (left.isString() && right.isString()) {
+                    MemoryScope memory(MemoryTag::STRINGS);
+                    left = concatenate(heap, left, right);
+                } else {
+                    runtimeError(chunk, currentOffset(), "Operands must be numbers. ");
+                }
+                stack.pop_back();
+                // Between instructions every live object is on the stack, in a
+                // global, or reachable from a closure there
+                if (heap.shouldCollect()) [[unlikely]] collectGarbage();
+                break;
+            }
+            case OpCode::NOT:
+                stack.back() = Value(!isTruthy(stack.back()));
+                break;
+            case OpCode::NEGATE:
+                if (!stack.back().isNumber()) {
+                    runtimeError(chunk, currentOffset(), "Operand must be a number.");
+                }
+                stack.back().number = -stack.back().number;
+                break;
+            case OpCode::PRINT:
+                printValue(std::cout, stack.back());
+                stack.pop_back();
+                break;
+            case OpCode::JUMP: {
+                uint32_t offset = readLong();
+                ip += offset;
+                break;
+            }
+            case OpCode::JUMP_IF_FALSE: {
+                uint32_t offset = readLong();
+                if (!isTruthy(stack.back())) ip += offset;
+                break;
+            }
+            case OpCode::LOOP: {
+                uint32_t offset = readLong();
+                ip -= offset;
+                break;
+            }
+            case OpCode::CLOSURE: {
+                const FunctionProto& function = chunk.functions[readLong()];
+                {
+                    MemoryScope memory(MemoryTag::FUNCTIONS);
+                    Closure* made = heap.make<Closure>(&function);
+                    stack.emplace_back(ValueType::FUNCTION, made);  // First, so it can capture its own slot
+                    for (uint16_t i = 0; i < function.upvalueCount; i++) {
+                        bool isLocal = *ip++;
+                        uint16_t index = readShort();
+                        made->upvalues.push_back(isLocal ? captureUpvalue(base + index) : closure->upvalues[index]);
+                    }
+                }
+                if (heap.shouldCollect()) [[unlikely]] collectGarbage();
+                break;
+            }
+            case OpCode::CLOSE_UPVALUE:
+                closeUpvalues(stack.size() - 1);
+                stack.pop_back();
+                break;
+            case OpCode::CHECK_CALL: {
+                size_t offset = currentOffset();
+                int count = *ip++;
+                const Value& callee = stack.back();
+                if (!callee.isFunction()) {
+                    runtimeError(chunk, offset, "Can only call functions and classes.");
+                }
+                int arity = asClosure(callee).function->arity;
+                if (count != arity) {
+                    runtimeError(chunk, offset, "Expected " + std::to_string(arity) + " arguments but got " +
+                                                    std::to_string(count) + ".");
+                }
+                break;
+            }
+            case OpCode::CALL: {
+                size_t offset = currentOffset();
+                int count = *ip++;
+                if (frames.size() >= static_cast<size_t>(maxCallDepth)) {
+                    runtimeError(chunk, offset, "Stack overflow.");
+                }
+                frames.push_back({closure, ip, base});
+                base = stack.size() - count;
+                closure = &asClosure(stack[base - 1]);
+                ip = code + closure->function->entry;
+                break;
+            }
+            case OpCode::TAIL_CALL: {
+                // The callee and its arguments take the place of the current call's
+                int count = *ip++;
+                closeUpvalues(base);
+                auto callee = stack.end() - count - 1;
+                std::move(callee, stack.end(), stack.begin() + (base - 1));
+                stack.resize(base + count);
+                closure = &asClosure(stack[base - 1]);
+                ip = code + closure->function->entry;
+                break;
+            }
+            case OpCode::RETURN: {
+                if (frames.empty()) return;
+                Value result = stack.back();
+                closeUpvalues(base);
+                stack.resize(base - 1);
+                stack.push_back(result);
+                const CallFrame& caller = frames.back();
+                closure = caller.closure;
+                ip = caller.returnIp;
+                base = caller.base;
+                frames.pop_back();
+                break;
+            }
+        }
+    }
+}
+
+// Reuses the upvalue another closure already made for the slot, so both see
+// the same variable
+Upvalue* VM::captureUpvalue(size_t slot) {
+    size_t i = openUpvalues.size();
+    while (i > 0 && openUpvalues[i - 1]->slot > slot) i--;
+    if (i > 0 && openUpvalues[i - 1]->slot == slot) {
+        return openUpvalues[i - 1];
+    }
+    Upvalue* upvalue = heap.make<Upvalue>(slot);
+    openUpvalues.insert(openUpvalues.begin() + static_cast<std::ptrdiff_t>(i), upvalue);
+    return upvalue;
+}
+
+// The slots from `fromSlot` up are going away: their captured values move
+// into the upvalues
+void VM::closeUpvalues(size_t fromSlot) {
+    while (!openUpvalues.empty() && openUpvalues.back()->slot >= fromSlot) {
+        Upvalue* upvalue = openUpvalues.back();
+        upvalue->closed = stack[upvalue->slot];
+        upvalue->open = false;
+        openUpvalues.pop_back();
+    }
+}
+
+void VM::collectGarbage() {
+    heap.collect([this](Heap& heap) {
+        for (const Value& value : stack) heap.mark(value);
+        for (const Value& value : globals) heap.mark(value);
+        for (Upvalue* upvalue : openUpvalues) heap.mark(upvalue);  // Even if no closure holds it any more
+    });
+}
+
+void VM::runtimeError(const Chunk& chunk, size_t offset, const std::string& message) {
+    std::cerr << message << "\n[line " << chunk.getLine(offset) << "]\n";
+    exit(70);
+}
@@ -0,0 +1,45 @@
+#ifndef VM_H
+#define VM_H
+
+#include <string>
+#include <vector>
+#include "chunk.h"
+#include "closure.h"
+#include "heap.h"
+#include "value.h"
+
+// Stack machine executing a compiled Chunk. Produces the same output and
+// runtime errors as the tree-walking Evaluator.
+class VM {
+public:
+    explicit VM(GcConfig gc = {});
+
+    // Calls nested deeper than this stop the program with "Stack overflow."
+    void setMaxCallDepth(int depth) { maxCallDepth = depth; }
+    void run(const Chunk& chunk);
+
+private:
+    // A call in progress, as the caller left it. The callee's arguments
+    // start at the stack slot its frame counts locals from; the closure
+    // being called sits just below them.
+    struct CallFrame {
+        Closure* closure;
+        const uint8_t* returnIp;
+        size_t base;
+    };
+
+    Heap heap;  // Runtime strings and closures; constants are interned and live outside it
+    std::vector<Value> stack;
+    std::vector<Value> globals;
+    std::vector<bool> defined;
+    std::vector<CallFrame> frames;
+    std::vector<Upvalue*> openUpvalues;  // Still in their stack slot, ordered by slot
+    int maxCallDepth;
+
+    Upvalue* captureUpvalue(size_t slot);
+    void closeUpvalues(size_t fromSlot);
+    void collectGarbage();
+    [[noreturn]] void runtimeError(const Chunk& chunk, size_t offset, const std::string& message);
+};
+
+#endif // VM_H
@@ -0,0 +1,50 @@
+# Runs one tests/*.lox script and checks it against the expectations written
+# in its comments:
+#
+#   // expect: <line>   a line of stdout, in order; empty when <line> is
+#   // error: <line>    a line of stderr, in order
+#   // exit: <code>     the exit status (default 0)
+#   // args: <flags>    extra flags passed before the script
+#   // modes: <list>    commands to run it under (read by CMakeLists.txt)
+#
+#   cmake -DINTERPRETER=<path> -DMODE=<command> -DSCRIPT=<file> -P run_lox_test.cmake
+
+file(STRINGS "${SCRIPT}" lines)
+set(expected_out "")
+set(expected_err "")
+set(expected_exit 0)
+set(args "")
+foreach(line IN LISTS lines)
+  if(line MATCHES "// expect:( (.*))?$")
+    string(APPEND expected_out "${CMAKE_MATCH_2}\n")
+  elseif(line MATCHES "// error: (.*)$")
+    string(APPEND expected_err "${CMAKE_MATCH_1}\n")
+  elseif(line MATCHES "// exit: ([0-9]+)")
+    set(expected_exit ${CMAKE_MATCH_1})
+  elseif(line MATCHES "// args: (.*)$")
+    separate_arguments(args UNIX_COMMAND "${CMAKE_MATCH_1}")
+  endif()
+endforeach()
+
+execute_process(
+  COMMAND "${INTERPRETER}" ${MODE} ${args} "${SCRIPT}"
+  OUTPUT_VARIABLE out
+  ERROR_VARIABLE err
+  RESULT_VARIABLE code)
+
+set(failed FALSE)
+if(NOT "${code}" STREQUAL "${expected_exit}")
+  message(SEND_ERROR "exit status ${code}, expected ${expected_exit}")
+  set(failed TRUE)
+endif()
+if(NOT "${out}" STREQUAL "${expected_out}")
+  message(SEND_ERROR "stdout:\n${out}expected:\n${expected_out}")
+  set(failed TRUE)
+endif()
+if(NOT "${err}" STREQUAL "${expected_err}")
+  message(SEND_ERROR "stderr:\n${err}expected:\n${expected_err}")
+  set(failed TRUE)
+endif()
+if(failed)
+  message(FATAL_ERROR "${SCRIPT} failed under `${MODE}`")
+endif()